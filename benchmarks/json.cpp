@@ -0,0 +1,294 @@
+#include <auxiliary/json.hpp>
+
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+
+// every heap allocation of the process goes through here, including the blocks of JsonArena
+static std::atomic<size_t> allocation_count = 0;
+
+void* operator new(size_t size) {
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+	throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	return std::malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size) { return ::operator new(size); }
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return ::operator new(size, tag); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace
+{
+	using namespace auxiliary;
+
+	struct Result {
+		double ns_per_message;
+		double allocations_per_message;
+	};
+
+	template<typename F>
+	Result measure(size_t iterations, F&& f) {
+		const size_t allocations = allocation_count.load();
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; i++) {
+			f(i);
+		}
+		const auto stop = std::chrono::steady_clock::now();
+		return {
+			std::chrono::duration<double, std::nano>(stop - start).count() / static_cast<double>(iterations),
+			static_cast<double>(allocation_count.load() - allocations) / static_cast<double>(iterations)
+		};
+	}
+
+	void report(const char* name, const Result& result) {
+		std::printf("%-40s %10.1f ns/msg %8.2f allocs/msg\n", name, result.ns_per_message, result.allocations_per_message);
+	}
+
+	void write_message(JsonWriter& writer, size_t i) {
+		(void) writer.start_object(u8"");
+		(void) writer.write(u8"id", static_cast<uint64_t>(i));
+		(void) writer.write(u8"name", u8string_view{u8"telemetry"});
+		(void) writer.write(u8"value", static_cast<double>(i) * 0.5);
+		(void) writer.write(u8"valid", true);
+		(void) writer.start_array(u8"samples");
+		for (int64_t s = 0; s < 8; s++) {
+			(void) writer.write(u8"", s);
+		}
+		(void) writer.end_array();
+		(void) writer.end_object();
+	}
+
+	void read_message(JsonReader& reader) {
+		uint64_t id;
+		double value;
+		bool valid;
+		int64_t samples[8];
+		(void) reader.start_object(u8"");
+		(void) reader.read(u8"id", id);
+		(void) reader.read(u8"value", value);
+		(void) reader.read(u8"valid", valid);
+		(void) reader.start_array(u8"samples");
+		(void) reader.read(8, samples);
+		(void) reader.end_array();
+		(void) reader.end_object();
+	}
+
+	void benchmark_reset(size_t iterations) {
+		u8string output;
+
+		report("JsonWriter fresh per message", measure(iterations, [&](size_t i) {
+			JsonWriter writer(4);
+			write_message(writer, i);
+			(void) writer.dump_to(output);
+		}));
+
+		JsonWriter writer(4);
+		report("JsonWriter reset per message", measure(iterations, [&](size_t i) {
+			writer.reset();
+			write_message(writer, i);
+			(void) writer.dump_to(output);
+		}));
+
+		report("JsonReader fresh per message", measure(iterations, [&](size_t) {
+			JsonReader reader(output);
+			read_message(reader);
+		}));
+
+		JsonReader reader(output);
+		report("JsonReader reset per message", measure(iterations, [&](size_t) {
+			reader.reset(output);
+			read_message(reader);
+		}));
+	}
+
+	// construct, read a 10-field object and destroy, the dominant per-message pattern
+	void benchmark_small_object(size_t iterations) {
+		const u8string_view json = u8R"({"f0":0,"f1":1,"f2":2,"f3":3,"f4":4,"f5":5,"f6":6,"f7":7,"f8":8,"f9":9})";
+		static constexpr const char8_t* keys[] = {u8"f0", u8"f1", u8"f2", u8"f3", u8"f4", u8"f5", u8"f6", u8"f7", u8"f8", u8"f9"};
+
+		for (auto [name, mode] : {std::pair{"JsonReader 10 fields document", JsonReadMode::Document}, std::pair{"JsonReader 10 fields on demand", JsonReadMode::OnDemand}}) {
+			int64_t sum = 0;
+			report(name, measure(iterations, [&](size_t) {
+				JsonReader reader(json, mode);
+				(void) reader.start_object(u8"");
+				for (auto key : keys) {
+					int64_t value = 0;
+					(void) reader.read(key, value);
+					sum += value;
+				}
+				(void) reader.end_object();
+			}));
+			if (sum != static_cast<int64_t>(iterations) * 45) {
+				std::printf("unexpected sum %lld\n", static_cast<long long>(sum));
+			}
+		}
+	}
+
+	// change one field of a message and serialize it again
+	void benchmark_edit(size_t iterations) {
+		u8string input;
+		JsonWriter source(4);
+		write_message(source, 1);
+		(void) source.dump_to(input);
+
+		u8string output;
+		JsonWriter writer(4);
+		report("JsonWriter rebuild to change a field", measure(iterations, [&](size_t i) {
+			JsonReader reader(input);
+			read_message(reader);
+			writer.reset();
+			write_message(writer, i);
+			(void) writer.dump_to(output);
+		}));
+
+		const auto id = JsonPath::compile(u8"id");
+		for (auto [name, mode] : {std::pair{"JsonWriter edit document", JsonReadMode::Document}, std::pair{"JsonWriter edit on demand", JsonReadMode::OnDemand}}) {
+			report(name, measure(iterations, [&](size_t i) {
+				JsonReader reader(input, mode);
+				(void) writer.edit(reader);
+				(void) writer.set(*id, static_cast<uint64_t>(i));
+				(void) writer.dump_to(output);
+			}));
+		}
+	}
+
+	void benchmark_bulk_write(size_t iterations) {
+		std::vector<float> floats(1024);
+		std::vector<int32_t> ints(1024);
+		for (size_t i = 0; i < floats.size(); i++) {
+			floats[i] = static_cast<float>(i) * 0.25f;
+			ints[i] = static_cast<int32_t>(i * 7919);
+		}
+
+		u8string output;
+		for (auto mode : {JsonWriteMode::Document, JsonWriteMode::Stream}) {
+			const char* suffix = mode == JsonWriteMode::Document ? "document" : "stream";
+			char name[64];
+
+			// what a float or int32 array cost before it had a bulk writer
+			JsonWriter writer(2, mode);
+			std::snprintf(name, sizeof(name), "float[1024] per element, %s", suffix);
+			report(name, measure(iterations, [&](size_t) {
+				writer.reset();
+				(void) writer.start_object(u8"");
+				(void) writer.start_array(u8"values");
+				for (float value : floats) {
+					(void) writer.write(u8"", value);
+				}
+				(void) writer.end_array();
+				(void) writer.end_object();
+				(void) writer.dump_to(output);
+			}));
+
+			std::snprintf(name, sizeof(name), "float[1024] bulk, %s", suffix);
+			report(name, measure(iterations, [&](size_t) {
+				writer.reset();
+				(void) writer.start_object(u8"");
+				(void) writer.write(floats.size(), u8"values", floats.data());
+				(void) writer.end_array();
+				(void) writer.end_object();
+				(void) writer.dump_to(output);
+			}));
+
+			std::snprintf(name, sizeof(name), "int32[1024] per element, %s", suffix);
+			report(name, measure(iterations, [&](size_t) {
+				writer.reset();
+				(void) writer.start_object(u8"");
+				(void) writer.start_array(u8"values");
+				for (int32_t value : ints) {
+					(void) writer.write(u8"", value);
+				}
+				(void) writer.end_array();
+				(void) writer.end_object();
+				(void) writer.dump_to(output);
+			}));
+
+			std::snprintf(name, sizeof(name), "int32[1024] bulk, %s", suffix);
+			report(name, measure(iterations, [&](size_t) {
+				writer.reset();
+				(void) writer.start_object(u8"");
+				(void) writer.write(ints.size(), u8"values", ints.data());
+				(void) writer.end_array();
+				(void) writer.end_object();
+				(void) writer.dump_to(output);
+			}));
+		}
+	}
+
+	struct FileSink : JsonSink {
+		std::FILE* file;
+
+		bool write(const char8_t* data, size_t size) override {
+			return std::fwrite(data, 1, size, file) == size;
+		}
+	};
+
+	void benchmark_ndjson_parallel(size_t megabytes) {
+		const char8_t* path = u8"ndjson_benchmark.jsonl";
+
+		// stream mode puts every root object on its own line
+		FileSink sink;
+		sink.file = std::fopen(reinterpret_cast<const char*>(path), "wb");
+		if (!sink.file) {
+			return;
+		}
+		{
+			JsonWriter writer(4, sink);
+			for (size_t i = 0; std::ftell(sink.file) < static_cast<long long>(megabytes) * 1024 * 1024; i++) {
+				write_message(writer, i);
+			}
+		}
+		const double size = static_cast<double>(std::ftell(sink.file)) / (1024.0 * 1024.0);
+		std::fclose(sink.file);
+
+		const size_t max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+		for (bool ordered : {true, false}) {
+			for (size_t threads = 1;; threads = std::min(threads * 2, max_threads)) {
+				NdjsonParallelOptions options;
+				options.threads = threads;
+				options.ordered = ordered;
+
+				std::atomic<size_t> records = 0;
+				const auto start = std::chrono::steady_clock::now();
+				(void) NdjsonReader::parse_file_parallel(path, [&](JsonReader& reader, size_t) {
+					read_message(reader);
+					records.fetch_add(1, std::memory_order_relaxed);
+				}, options);
+				const auto stop = std::chrono::steady_clock::now();
+
+				std::printf("NdjsonReader %-9s %3zu threads %10.1f MB/s %12zu records\n", ordered ? "ordered" : "unordered", threads,
+				            size / std::chrono::duration<double>(stop - start).count(), records.load());
+				if (threads == max_threads) {
+					break;
+				}
+			}
+		}
+
+		std::remove(reinterpret_cast<const char*>(path));
+	}
+}
+
+int main(int argc, char** argv) {
+	const size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+	// size of the generated NDJSON file, pass a few thousand for a multi-GB run
+	const size_t megabytes = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 256;
+
+	benchmark_reset(iterations);
+	benchmark_small_object(iterations);
+	benchmark_edit(iterations);
+	benchmark_bulk_write(std::max<size_t>(iterations / 100, 1));
+	benchmark_ndjson_parallel(megabytes);
+	return 0;
+}
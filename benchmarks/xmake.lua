@@ -0,0 +1,11 @@
+function BENCHMARK(name)
+    target(name .. "_benchmark")
+    do
+        set_kind("binary")
+        set_group("benchmark")
+        add_deps("auxiliary")
+        add_files(name .. ".cpp")
+    end
+end
+
+BENCHMARK("json")
@@ -1,123 +1,1923 @@
 #include "pch.hpp"
 #include "log.hpp"
+#include "json_text.hpp"
+#include "json_scan.hpp"
+#include "json_arena.hpp"
 
 #include <auxiliary/json.hpp>
 
 #include <yyjson.h>
 
+#include <bit>
+#include <mutex>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <limits>
+#include <thread>
+#include <vector>
+#include <cassert>
+#include <exception>
+#include <algorithm>
+#include <condition_variable>
+
+#ifdef _WIN32
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#endif
+
 namespace auxiliary
 {
 	struct JsonWriterDocument : yyjson_mut_doc {};
 
-	struct JsonWriterValue : yyjson_mut_val {};
+	struct JsonWriterValue : yyjson_mut_val {};
+
+	struct JsonReaderDocument : yyjson_doc {};
+
+	struct JsonReaderValue : yyjson_val {};
+
+	struct JsonWriterStream {
+		JsonTextBuffer buffer;
+		JsonSink* sink = nullptr;
+		size_t chunk_size = 0;
+		bool has_root = false;
+		bool failed = false;
+		// text has gone to the sink since the current value started at mark
+		bool flushed = false;
+		size_t mark = 0;
+
+		std::expected<void, JsonErrorCode> flush() {
+			if (sink && !failed && buffer.size() > 0) {
+				failed = !sink->write(buffer.data(), buffer.size());
+				flushed = true;
+				buffer.clear();
+			}
+			if (failed) {
+				return std::unexpected(JsonErrorCode::SinkWriteFailed);
+			}
+			return {};
+		}
+
+		// close a scope for the noexcept end_array() and end_object(), which get exceptions back as errors.
+		// Nothing changes if the bracket cannot be appended, a throwing sink counts as a failed one
+		template<typename Stack>
+		std::expected<void, JsonErrorCode> close(char8_t bracket, Stack& stack) noexcept {
+			try {
+				buffer.append(bracket);
+			} catch (const std::bad_alloc&) {
+				return std::unexpected(JsonErrorCode::UnknownError);
+			}
+			stack.pop();
+
+			try {
+				return stack.empty() ? flush() : commit();
+			} catch (...) {
+				failed = true;
+				return std::unexpected(JsonErrorCode::SinkWriteFailed);
+			}
+		}
+
+		// keep pending text bounded by chunk_size when writing to a sink
+		std::expected<void, JsonErrorCode> commit() {
+			if (sink && buffer.size() >= chunk_size) {
+				return flush();
+			}
+			if (failed) {
+				return std::unexpected(JsonErrorCode::SinkWriteFailed);
+			}
+			return {};
+		}
+
+		std::expected<void, JsonErrorCode> write_string(const char8_t* str, size_t len) {
+			buffer.append(u8'"');
+			const size_t max_slice = sink ? std::max<size_t>(chunk_size / json_text::max_escape_expansion, 4) : len;
+			while (len > max_slice) {
+				// never split a UTF-8 sequence between two slices
+				size_t slice = max_slice;
+				while (slice > max_slice - 3 && (str[slice] & 0xC0) == 0x80) {
+					slice--;
+				}
+				if (!json_text::write_escaped(buffer, str, slice)) {
+					return invalid_utf8();
+				}
+				str += slice;
+				len -= slice;
+				if (auto result = commit(); !result.has_value()) {
+					return result;
+				}
+			}
+			if (!json_text::write_escaped(buffer, str, len)) {
+				return invalid_utf8();
+			}
+			buffer.append(u8'"');
+			return {};
+		}
+
+		// text already handed to the sink can not be taken back, so the stream is broken from here on
+		std::unexpected<JsonErrorCode> invalid_utf8() {
+			failed = failed || flushed;
+			return std::unexpected(JsonErrorCode::InvalidUtf8);
+		}
+	};
+
+	struct JsonWriterAdopted {
+		struct Entry {
+			yyjson_mut_doc* document;
+			JsonArena* arena;
+		};
+
+		std::vector<Entry> entries;
+
+		~JsonWriterAdopted() {
+			release();
+		}
+
+		void release() noexcept {
+			for (auto& entry : entries) {
+				yyjson_mut_doc_free(entry.document);
+				delete entry.arena;
+			}
+			entries.clear();
+		}
+	};
+
+	FILE* OpenFile(const char8_t* path, const char* mode) {
+#ifdef _WIN32
+		const int length = MultiByteToWideChar(CP_UTF8, 0, reinterpret_cast<const char*>(path), -1, nullptr, 0);
+		std::wstring wpath(length, L'\0');
+		MultiByteToWideChar(CP_UTF8, 0, reinterpret_cast<const char*>(path), -1, wpath.data(), length);
+		std::wstring wmode(mode, mode + std::strlen(mode));
+		return _wfopen(wpath.c_str(), wmode.c_str());
+#else
+		return std::fopen(reinterpret_cast<const char*>(path), mode);
+#endif
+	}
+
+	// Read-only view of a whole file, its pages stay shared with the page cache
+	struct JsonMappedFile {
+		char8_t* data = nullptr;
+		size_t size = 0;
+	};
+
+	JsonMappedFile* MapFile(const char8_t* path) {
+#ifdef _WIN32
+		const int length = MultiByteToWideChar(CP_UTF8, 0, reinterpret_cast<const char*>(path), -1, nullptr, 0);
+		std::wstring wpath(length, L'\0');
+		MultiByteToWideChar(CP_UTF8, 0, reinterpret_cast<const char*>(path), -1, wpath.data(), length);
+
+		HANDLE file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return nullptr;
+		}
+
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size)) {
+			CloseHandle(file);
+			return nullptr;
+		}
+
+		auto mapped = new JsonMappedFile;
+		mapped->size = static_cast<size_t>(file_size.QuadPart);
+		if (mapped->size > 0) {
+			// the view keeps the mapping object alive once both handles are closed
+			HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping) {
+				mapped->data = static_cast<char8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				CloseHandle(mapping);
+			}
+			if (!mapped->data) {
+				CloseHandle(file);
+				delete mapped;
+				return nullptr;
+			}
+		}
+		CloseHandle(file);
+		return mapped;
+#else
+		const int fd = ::open(reinterpret_cast<const char*>(path), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			return nullptr;
+		}
+
+		struct stat st;
+		if (::fstat(fd, &st) != 0) {
+			::close(fd);
+			return nullptr;
+		}
+
+		auto mapped = new JsonMappedFile;
+		mapped->size = static_cast<size_t>(st.st_size);
+		if (mapped->size > 0) {
+			void* data = ::mmap(nullptr, mapped->size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data == MAP_FAILED) {
+				::close(fd);
+				delete mapped;
+				return nullptr;
+			}
+			::madvise(data, mapped->size, MADV_SEQUENTIAL);
+			mapped->data = static_cast<char8_t*>(data);
+		}
+		::close(fd);
+		return mapped;
+#endif
+	}
+
+	void UnmapFile(JsonMappedFile* mapped) noexcept {
+		if (!mapped) {
+			return;
+		}
+		if (mapped->data) {
+#ifdef _WIN32
+			UnmapViewOfFile(mapped->data);
+#else
+			::munmap(mapped->data, mapped->size);
+#endif
+		}
+		delete mapped;
+	}
+
+	// Open addressing tables over the keys of large objects, all sharing one slot array
+	struct JsonKeyIndex {
+		struct Slot {
+			size_t hash;
+			yyjson_val* key;
+		};
+
+		struct Table {
+			size_t first;
+			size_t mask;
+			// some key appears more than once, only the first of them is in the table
+			bool duplicated;
+		};
+
+		// table number of an object, open addressing as well
+		struct Object {
+			const yyjson_val* obj;
+			uint32_t table;
+		};
+
+		std::vector<Slot> slots;
+		std::vector<Table> tables;
+		std::vector<Object> objects;
+		// the object asked for last, paths through one object ask for it over and over
+		Object last = {nullptr, 0};
+
+		void clear() noexcept {
+			slots.clear();
+			tables.clear();
+			std::fill(objects.begin(), objects.end(), Object{nullptr, 0});
+			last = Object{nullptr, 0};
+		}
+
+		// table number of obj, built on first use
+		uint32_t find_table(yyjson_val* obj) {
+			if (last.obj == obj) {
+				return last.table;
+			}
+			if (tables.size() * 2 >= objects.size()) {
+				grow();
+			}
+
+			const size_t mask = objects.size() - 1;
+			size_t i = object_hash(obj) & mask;
+			while (objects[i].obj && objects[i].obj != obj) {
+				i = (i + 1) & mask;
+			}
+			if (!objects[i].obj) {
+				objects[i] = Object{obj, build(obj)};
+			}
+			last = objects[i];
+			return last.table;
+		}
+
+		yyjson_val* find(uint32_t table, u8string_view key, size_t hash) const noexcept {
+			const auto& [first, mask, duplicated] = tables[table - 1];
+			for (size_t i = hash & mask;; i = (i + 1) & mask) {
+				const Slot& slot = slots[first + i];
+				if (!slot.key) {
+					return nullptr;
+				}
+				if (slot.hash == hash && yyjson_get_len(slot.key) == key.size() && std::memcmp(yyjson_get_str(slot.key), key.data(), key.size()) == 0) {
+					return yyjson_obj_iter_get_val(slot.key);
+				}
+			}
+		}
+
+		[[nodiscard]] bool unique_keys(uint32_t table) const noexcept {
+			return !tables[table - 1].duplicated;
+		}
+
+	private:
+		uint32_t build(yyjson_val* obj) {
+			const size_t first = slots.size();
+			const size_t mask = std::bit_ceil(yyjson_obj_size(obj) * 2) - 1;
+			slots.resize(first + mask + 1, Slot{0, nullptr});
+			bool duplicated = false;
+
+			yyjson_obj_iter iter;
+			yyjson_obj_iter_init(obj, &iter);
+			while (auto key = yyjson_obj_iter_next(&iter)) {
+				const u8string_view name{reinterpret_cast<const char8_t*>(yyjson_get_str(key)), yyjson_get_len(key)};
+				const size_t hash = Hash<u8string_view>()(name);
+
+				// the first of duplicated keys wins, like yyjson_obj_get
+				size_t i = hash & mask;
+				while (slots[first + i].key && !(slots[first + i].hash == hash && yyjson_get_len(slots[first + i].key) == name.size()
+				                                 && std::memcmp(yyjson_get_str(slots[first + i].key), name.data(), name.size()) == 0)) {
+					i = (i + 1) & mask;
+				}
+				if (!slots[first + i].key) {
+					slots[first + i] = Slot{hash, key};
+				} else {
+					duplicated = true;
+				}
+			}
+
+			tables.push_back(Table{first, mask, duplicated});
+			return static_cast<uint32_t>(tables.size());
+		}
+
+		static size_t object_hash(const yyjson_val* obj) noexcept {
+			return XXHash::xxhash(reinterpret_cast<const std::byte*>(&obj), sizeof(obj));
+		}
+
+		void grow() {
+			std::vector<Object> old(std::max<size_t>(objects.size() * 2, 16), Object{nullptr, 0});
+			old.swap(objects);
+
+			const size_t mask = objects.size() - 1;
+			for (const Object& entry : old) {
+				if (entry.obj) {
+					size_t i = object_hash(entry.obj) & mask;
+					while (objects[i].obj) {
+						i = (i + 1) & mask;
+					}
+					objects[i] = entry;
+				}
+			}
+		}
+	};
+
+	// Input and scan positions of a reader in on demand mode, one level per open scope of the reader
+	struct JsonLazyDocument {
+		struct Level {
+			// first member or element
+			size_t begin = JsonScanner::npos;
+			// next member or element, or the closing bracket
+			size_t cursor = JsonScanner::npos;
+			// start of a child container, cursor is behind it once it has been skipped
+			size_t pending = JsonScanner::npos;
+			// behind the closing bracket, once a scan has reached it
+			size_t end = JsonScanner::npos;
+		};
+
+		enum EValidity : uint8_t {
+			kUnchecked,
+			kValid,
+			kInvalid
+		};
+
+		JsonScanner scanner;
+		// unescaped strings handed out by read()
+		JsonArena strings;
+		// JsonWriter::edit() checks the whole input once per document
+		EValidity validity = kUnchecked;
+		JsonTextBuffer scratch;
+		std::vector<Level> stack;
+	};
+
+	struct JsonFileSource final : JsonSource {
+		std::FILE* file = nullptr;
+
+		~JsonFileSource() override {
+			if (file) {
+				std::fclose(file);
+			}
+		}
+
+		bool read(char8_t* buffer, size_t capacity, size_t& size) override {
+			size = std::fread(buffer, 1, capacity, file);
+			return size == capacity || !std::ferror(file);
+		}
+	};
+
+	// Chunk buffer of NdjsonReader, bytes in [begin, end) are not consumed yet
+	struct NdjsonInput {
+		std::unique_ptr<char8_t[]> data;
+		size_t capacity = 0;
+		size_t begin = 0;
+		// no newline in [begin, scanned)
+		size_t scanned = 0;
+		size_t end = 0;
+		bool eof = false;
+		JsonFileSource file;
+	};
+
+	// Bytes of the document being received, bytes past its end wait in pending for the next one
+	struct JsonFramerInput {
+		JsonTextBuffer buffer;
+		JsonTextBuffer pending;
+		JsonBoundaryScanner scanner;
+		bool complete = false;
+	};
+
+	yyjson_alc AllocatorBridge(JsonAllocator& allocator) noexcept {
+		yyjson_alc alc;
+		alc.malloc = [](void* ctx, size_t size) { return static_cast<JsonAllocator*>(ctx)->allocate(size); };
+		alc.realloc = [](void* ctx, void* ptr, size_t old_size, size_t size) { return static_cast<JsonAllocator*>(ctx)->reallocate(ptr, old_size, size); };
+		alc.free = [](void* ctx, void* ptr) { static_cast<JsonAllocator*>(ctx)->deallocate(ptr); };
+		alc.ctx = &allocator;
+		return alc;
+	}
+
+	struct JsonImpl {
+		// JsonReader::set_error_logging()
+		static inline std::atomic<bool> log_parse_errors = false;
+
+		template<typename T>
+		static yyjson_alc document_allocator(const T& owner) noexcept {
+			return owner.allocator ? AllocatorBridge(*owner.allocator) : owner.arena->allocator();
+		}
+
+		// output memory of the previous dump is recycled, also with a user allocator, which may never get it back
+		static yyjson_alc output_allocator(const JsonWriter& w) {
+			if (w.scratch) {
+				w.scratch->rewind();
+			} else {
+				w.scratch = new JsonArena;
+			}
+			return w.scratch->allocator();
+		}
+
+		// hand the null terminated text of the writer to consume
+		template<typename F>
+		static std::expected<size_t, JsonErrorCode> serialize(const JsonWriter& w, F&& consume) {
+			if (w.stream) {
+				*w.stream->buffer.reserve(1) = u8'\0';
+				return consume(w.stream->buffer.view());
+			}
+
+			auto alc = output_allocator(w);
+			size_t len = 0;
+			auto str = yyjson_mut_write_opts(w.document, 0, &alc, &len, nullptr);
+			if (!str) {
+				return std::unexpected(JsonErrorCode::UnknownError);
+			}
+
+			auto result = consume(u8string_view{reinterpret_cast<const char8_t*>(str), len});
+			alc.free(alc.ctx, str);
+			return result;
+		}
+
+		static std::expected<void, JsonErrorCode> splice(JsonWriter& w, u8string_view key, JsonWriter& child) {
+			using enum JsonErrorCode;
+
+			if (w.stack.empty()) {
+				return std::unexpected(NoOpenScope);
+			}
+
+			const bool finished = child.stream ? child.stream->has_root : yyjson_mut_doc_get_root(child.document) != nullptr;
+			if (!finished || !child.stack.empty() || (child.stream && (child.stream->sink || !w.stream))) {
+				return std::unexpected(ChildNotSpliceable);
+			}
+
+			if (w.stream) {
+				if (auto result = stream_prefix(w, key); !result.has_value()) {
+					return result;
+				}
+				auto result = serialize(child, [&](u8string_view text) -> std::expected<size_t, JsonErrorCode> {
+					w.stream->buffer.append(text.data(), text.size());
+					return text.size();
+				});
+				if (!result.has_value()) {
+					return std::unexpected(result.error());
+				}
+				child.reset();
+				return w.stream->commit();
+			}
+
+			const auto level = w.stack.top();
+			if (auto result = check_key(level, key); !result.has_value()) {
+				return result;
+			}
+			if (!attach(w, level, key, yyjson_mut_doc_get_root(child.document))) {
+				return std::unexpected(UnknownError);
+			}
+
+			// the values stay in the pools of child, which now belong to w
+			if (!w.adopted) {
+				w.adopted = new JsonWriterAdopted;
+			}
+			w.adopted->entries.push_back({child.document, child.arena});
+			child.document = nullptr;
+			child.arena = child.allocator ? nullptr : new JsonArena;
+			child.reset();
+			return {};
+		}
+
+		static std::expected<void, JsonErrorCode> edit(JsonWriter& w, const JsonReader& r) {
+			using enum JsonErrorCode;
+
+			if (w.stream) {
+				return std::unexpected(ScopeTypeMismatch);
+			}
+			w.reset();
+
+			yyjson_mut_val* root;
+			if (r.lazy) {
+				// raw text goes to the output unchecked, so the input is validated by the first edit() and the outcome kept
+				auto& d = *r.lazy;
+				const auto& scanner = d.scanner;
+				if (d.validity == JsonLazyDocument::kUnchecked) {
+					d.validity = JsonValidator::validate(scanner.data(), scanner.size()).valid() ? JsonLazyDocument::kValid : JsonLazyDocument::kInvalid;
+				}
+				if (d.validity == JsonLazyDocument::kInvalid) {
+					return std::unexpected(ParseFailed);
+				}
+				const size_t begin = scanner.skip_whitespace(0);
+				const size_t end = scanner.skip_value(begin);
+				root = yyjson_mut_rawn(w.document, reinterpret_cast<const char*>(scanner.data() + begin), end - begin);
+			} else {
+				if (!r.document) {
+					return std::unexpected(ParseFailed);
+				}
+				root = yyjson_val_mut_copy(w.document, yyjson_doc_get_root(r.document));
+			}
+
+			if (!root) {
+				return std::unexpected(UnknownError);
+			}
+			yyjson_mut_doc_set_root(w.document, root);
+			return {};
+		}
+
+		// a raw container turns into a container of raw members where it is, so each edit only splits the levels its path crosses
+		static std::expected<yyjson_mut_val*, JsonErrorCode> expand(JsonWriter& w, yyjson_mut_val* val) {
+			if (!yyjson_mut_is_raw(val)) {
+				return val;
+			}
+
+			// the raw text stays in the input, only the node is reused
+			const JsonScanner scanner{reinterpret_cast<const char8_t*>(yyjson_mut_get_raw(val)), yyjson_mut_get_len(val)};
+			const bool object = scanner.at(0) == u8'{';
+			if (!object && scanner.at(0) != u8'[') {
+				return val;
+			}
+
+			yyjson_mut_val* container = val;
+			if (object) {
+				yyjson_mut_set_obj(container);
+			} else {
+				yyjson_mut_set_arr(container);
+			}
+
+			JsonTextBuffer scratch;
+			for (size_t pos = scanner.skip_whitespace(1); scanner.at(pos) != u8'}' && scanner.at(pos) != u8']';) {
+				yyjson_mut_val* key = nullptr;
+				if (object) {
+					// keys without escapes are referenced like the values
+					const size_t key_end = scanner.skip_string(pos);
+					const char8_t* content = scanner.data() + pos + 1;
+					const size_t length = key_end - pos - 2;
+					if (std::memchr(content, u8'\\', length) == nullptr) {
+						key = yyjson_mut_strn(w.document, reinterpret_cast<const char*>(content), length);
+					} else {
+						scratch.clear();
+						(void) scanner.read_string(pos, scratch);
+						key = yyjson_mut_strncpy(w.document, reinterpret_cast<const char*>(scratch.data()), scratch.size());
+					}
+					pos = scanner.skip_whitespace(scanner.skip_whitespace(key_end) + 1);
+				}
+
+				const size_t end = scanner.skip_value(pos);
+				yyjson_mut_val* member = yyjson_mut_rawn(w.document, reinterpret_cast<const char*>(scanner.data() + pos), end - pos);
+				if (!member || (object ? !yyjson_mut_obj_add(container, key, member) : !yyjson_mut_arr_append(container, member))) {
+					return std::unexpected(JsonErrorCode::UnknownError);
+				}
+				pos = scanner.next_member(end);
+			}
+			return container;
+		}
+
+		// the child step names, expanded in place when it is still raw text
+		static std::expected<yyjson_mut_val*, JsonErrorCode> edit_child(JsonWriter& w, yyjson_mut_val* val, const JsonPath& path, const JsonPath::Step& step) {
+			const u8string_view key = step_key(path, step);
+			const bool object = yyjson_mut_is_obj(val);
+
+			yyjson_mut_val* child = nullptr;
+			if (object) {
+				child = yyjson_mut_obj_getn(val, reinterpret_cast<const char*>(key.data()), key.size());
+			} else if (yyjson_mut_is_arr(val) && step.index != SIZE_MAX) {
+				child = yyjson_mut_arr_get(val, step.index);
+			}
+			if (!child) {
+				return std::unexpected(JsonErrorCode::KeyNotFound);
+			}
+
+			return expand(w, child);
+		}
+
+		static yyjson_mut_val* patch_value(JsonWriter& w, const JsonPathValue& value, bool raw) {
+			switch (value.type) {
+				case JsonPathValue::kNull: return yyjson_mut_null(w.document);
+				case JsonPathValue::kBool: return yyjson_mut_bool(w.document, value.boolean);
+				case JsonPathValue::kSint: return yyjson_mut_sint(w.document, value.sint);
+				case JsonPathValue::kUint: return yyjson_mut_uint(w.document, value.uint);
+				case JsonPathValue::kReal: return yyjson_mut_real(w.document, value.real);
+				case JsonPathValue::kString: {
+					const auto text = reinterpret_cast<const char*>(value.string);
+					return raw ? yyjson_mut_rawncpy(w.document, text, value.length) : yyjson_mut_strncpy(w.document, text, value.length);
+				}
+				case JsonPathValue::kArray: return yyjson_mut_arr(w.document);
+				case JsonPathValue::kObject: return yyjson_mut_obj(w.document);
+				default: return nullptr;
+			}
+		}
+
+		static std::expected<void, JsonErrorCode> patch(JsonWriter& w, const JsonPath& path, JsonWriter::EPatch mode, const JsonPathValue& value, bool raw) {
+			using enum JsonErrorCode;
+			using enum JsonWriter::EPatch;
+
+			if (w.stream || !w.stack.empty()) {
+				return std::unexpected(ScopeTypeMismatch);
+			}
+
+			yyjson_mut_val* root = yyjson_mut_doc_get_root(w.document);
+			if (!root) {
+				return std::unexpected(NoOpenScope);
+			}
+
+			if (mode != kRemove && value.type == JsonPathValue::kReal) {
+				if (auto result = check_value(value.real); !result.has_value()) {
+					return result;
+				}
+			} else if (mode != kRemove && value.type == JsonPathValue::kString && raw) {
+				if (auto result = check_value(JsonRawNumber{value.string, value.length}); !result.has_value()) {
+					return result;
+				}
+			}
+
+			yyjson_mut_val* val = nullptr;
+			if (mode != kRemove && !(val = patch_value(w, value, raw))) {
+				return std::unexpected(UnknownError);
+			}
+
+			if (path.size() == 0) {
+				if (mode != kSet) {
+					return std::unexpected(InvalidPath);
+				}
+				yyjson_mut_doc_set_root(w.document, val);
+				return {};
+			}
+
+			auto node = expand(w, root);
+			for (size_t i = 0; node.has_value() && i + 1 < path.size(); i++) {
+				node = edit_child(w, node.value(), path, path.steps[i]);
+			}
+			if (!node.has_value()) {
+				return std::unexpected(node.error());
+			}
+
+			yyjson_mut_val* parent = node.value();
+			const auto& step = path.steps.back();
+			bool done;
+			if (yyjson_mut_is_obj(parent)) {
+				const u8string_view key = step_key(path, step);
+				const auto k = reinterpret_cast<const char*>(key.data());
+				if (mode == kRemove) {
+					done = yyjson_mut_obj_remove_keyn(parent, k, key.size()) != nullptr;
+				} else if (yyjson_mut_val* member = yyjson_mut_obj_getn(parent, k, key.size())) {
+					// the member node takes the new value where it stands, the key is left alone
+					member->tag = val->tag;
+					member->uni = val->uni;
+					done = true;
+				} else {
+					done = yyjson_mut_obj_add(parent, yyjson_mut_strncpy(w.document, k, key.size()), val);
+				}
+			} else if (yyjson_mut_is_arr(parent) && step.index != SIZE_MAX) {
+				const size_t size = yyjson_mut_arr_size(parent);
+				if (mode == kRemove) {
+					done = step.index < size && yyjson_mut_arr_remove(parent, step.index);
+				} else if (mode == kSet && step.index < size) {
+					done = yyjson_mut_arr_replace(parent, step.index, val) != nullptr;
+				} else {
+					done = step.index <= size && yyjson_mut_arr_insert(parent, val, step.index);
+				}
+			} else {
+				return std::unexpected(ScopeTypeMismatch);
+			}
+
+			if (!done) {
+				return std::unexpected(KeyNotFound);
+			}
+			return {};
+		}
+
+		static yyjson_val* next_element(JsonReader::Level& level) noexcept {
+			const auto index = level.index++;
+			if (index >= yyjson_arr_size(level.value)) {
+				return nullptr;
+			}
+
+			yyjson_val* element = index == 0 ? yyjson_arr_get_first(level.value) : unsafe_yyjson_get_next(level.cursor);
+			level.cursor = reinterpret_cast<JsonReaderValue*>(element);
+			return element;
+		}
+
+		// small objects are scanned, large ones looked up through their hash index
+		static yyjson_val* lookup_member(JsonReader& r, JsonReader::Level& level, u8string_view key) {
+			yyjson_val* obj = level.value;
+			if (yyjson_obj_size(obj) <= r.key_index_threshold) {
+				return yyjson_obj_getn(obj, reinterpret_cast<const char*>(key.data()), key.size());
+			}
+
+			if (!r.key_index) {
+				r.key_index = new JsonKeyIndex;
+			}
+			if (level.key_table == 0) {
+				level.key_table = r.key_index->find_table(obj);
+			}
+
+			const bool is_static = r.static_key && r.static_key->view().data() == key.data() && r.static_key->view().size() == key.size();
+			const size_t hash = is_static ? r.static_key->hash() : Hash<u8string_view>()(key);
+			return r.key_index->find(level.key_table, key, hash);
+		}
+
+		// checked once per level, the large objects through their table
+		static bool unique_keys(JsonReader& r, JsonReader::Level& level) {
+			using enum JsonReader::Level::EKeys;
+
+			if (level.keys == kKeysUnchecked) {
+				yyjson_val* obj = level.value;
+				bool unique = true;
+				if (yyjson_obj_size(obj) <= r.key_index_threshold) {
+					yyjson_val* end = unsafe_yyjson_get_next(obj);
+					for (yyjson_val* a = unsafe_yyjson_get_first(obj); unique && a != end; a = unsafe_yyjson_get_next(yyjson_obj_iter_get_val(a))) {
+						for (yyjson_val* b = unsafe_yyjson_get_next(yyjson_obj_iter_get_val(a)); b != end; b = unsafe_yyjson_get_next(yyjson_obj_iter_get_val(b))) {
+							if (yyjson_get_len(a) == yyjson_get_len(b) && std::memcmp(yyjson_get_str(a), yyjson_get_str(b), yyjson_get_len(a)) == 0) {
+								unique = false;
+								break;
+							}
+						}
+					}
+				} else {
+					if (!r.key_index) {
+						r.key_index = new JsonKeyIndex;
+					}
+					if (level.key_table == 0) {
+						level.key_table = r.key_index->find_table(obj);
+					}
+					unique = r.key_index->unique_keys(level.key_table);
+				}
+				level.keys = unique ? kKeysUnique : kKeysDuplicated;
+			}
+			return level.keys == kKeysUnique;
+		}
+
+		static yyjson_val* find_member(JsonReader& r, JsonReader::Level& level, u8string_view key) {
+			yyjson_val* obj = level.value;
+			if (yyjson_obj_size(obj) == 0) {
+				return nullptr;
+			}
+
+			// a match past the first member is only the first of its key when the keys are unique
+			yyjson_val* found = nullptr;
+			yyjson_val* hint = level.cursor ? level.cursor : unsafe_yyjson_get_first(obj);
+			if (yyjson_get_len(hint) == key.size() && std::memcmp(yyjson_get_str(hint), key.data(), key.size()) == 0 && (!level.cursor || unique_keys(r, level))) {
+				found = yyjson_obj_iter_get_val(hint);
+			} else {
+				found = lookup_member(r, level, key);
+			}
+
+			if (found) {
+				// the key after the last member is the end of the object, wrap around to the first one
+				yyjson_val* next = unsafe_yyjson_get_next(found);
+				level.cursor = reinterpret_cast<JsonReaderValue*>(next == unsafe_yyjson_get_next(obj) ? nullptr : next);
+			}
+			return found;
+		}
+
+		static std::expected<void, JsonErrorCode> check_key(const JsonWriter::Level& level, u8string_view key) noexcept {
+			using enum JsonErrorCode;
+
+			if (level.type == JsonWriter::Level::kObject) {
+				if (key.empty()) {
+					return std::unexpected(EmptyObjectFieldKey);
+				}
+			} else if (!key.empty()) {
+				return std::unexpected(ArrayElementWithKey);
+			}
+			return {};
+		}
+
+		// static keys are referenced by the document instead of copied into it
+		static yyjson_mut_val* make_key(const JsonWriter& w, u8string_view key) {
+			const char* ckey = reinterpret_cast<const char*>(key.data());
+			if (key.data() == w.borrowed_key) {
+				return yyjson_mut_strn(w.document, ckey, key.size());
+			}
+			return yyjson_mut_strncpy(w.document, ckey, key.size());
+		}
+
+		// add val to the scope of level, key has been checked already
+		static bool attach(const JsonWriter& w, const JsonWriter::Level& level, u8string_view key, yyjson_mut_val* val) {
+			if (!val) {
+				return false;
+			}
+
+			if (level.type == JsonWriter::Level::kObject) {
+				yyjson_mut_val* k = make_key(w, key);
+				return k && yyjson_mut_obj_add(level.value, k, val);
+			}
+			return yyjson_mut_arr_append(level.value, val);
+		}
+
+		// validate key against the open scope, then emit the separator and key
+		static std::expected<void, JsonErrorCode> stream_prefix(JsonWriter& w, u8string_view key) {
+			using enum JsonWriter::Level::EType;
+
+			auto& level = w.stack.top();
+			auto& buffer = w.stream->buffer;
+
+			if (auto result = check_key(level, key); !result.has_value()) {
+				return result;
+			}
+
+			// a rejected string leaves no trace as long as nothing reached the sink
+			w.stream->flushed = false;
+			w.stream->mark = buffer.size();
+			if (level.count++ > 0) {
+				buffer.append(u8',');
+			}
+			if (level.type == kObject) {
+				buffer.append(u8'"');
+				if (!json_text::write_escaped(buffer, key.data(), key.size())) {
+					stream_rollback(w);
+					return std::unexpected(JsonErrorCode::InvalidUtf8);
+				}
+				buffer.append(u8"\":", 2);
+			}
+			return {};
+		}
+
+		static void stream_rollback(JsonWriter& w) {
+			if (!w.stream->flushed) {
+				w.stream->buffer.truncate(w.stream->mark);
+				w.stack.top().count--;
+			}
+		}
+
+		template<typename T, typename... Args>
+		static std::expected<void, JsonErrorCode> stream_write(JsonWriter& w, u8string_view key, T value, Args&&... args) {
+			if (auto result = stream_prefix(w, key); !result.has_value()) {
+				return result;
+			}
+
+			auto& buffer = w.stream->buffer;
+			if constexpr (std::is_same_v<T, bool>) {
+				json_text::write_bool(buffer, value);
+			} else if constexpr (std::is_integral_v<T>) {
+				json_text::write_integer(buffer, value);
+			} else if constexpr (std::is_floating_point_v<T>) {
+				json_text::write_real(buffer, value);
+			} else if constexpr (std::is_same_v<T, JsonRawNumber>) {
+				buffer.append(value.text, value.length);
+			} else {
+				if (auto result = w.stream->write_string(reinterpret_cast<const char8_t*>(value), std::forward<Args>(args)...); !result.has_value()) {
+					stream_rollback(w);
+					return result;
+				}
+			}
+			return w.stream->commit();
+		}
+
+		template<typename T, typename... Args>
+		static std::expected<void, JsonErrorCode> stream_write_array(JsonWriter& w, size_t count, u8string_view key, T values, const Args&... args) {
+			using U = std::remove_cvref_t<decltype(*values)>;
+
+			if (auto result = stream_prefix(w, key); !result.has_value()) {
+				return result;
+			}
+
+			auto& buffer = w.stream->buffer;
+			buffer.append(u8'[');
+			for (size_t i = 0; i < count; i++) {
+				if (i > 0) {
+					buffer.append(u8',');
+				}
+
+				if constexpr (std::is_same_v<U, bool>) {
+					json_text::write_bool(buffer, values[i]);
+				} else if constexpr (std::is_integral_v<U>) {
+					json_text::write_integer(buffer, values[i]);
+				} else if constexpr (std::is_floating_point_v<U>) {
+					// floats are widened like single float writes, so both modes print the same digits
+					json_text::write_real(buffer, static_cast<double>(values[i]));
+				} else {
+					if (auto result = w.stream->write_string(reinterpret_cast<const char8_t*>(values[i]), args[i]...); !result.has_value()) {
+						stream_rollback(w);
+						return result;
+					}
+				}
+
+				if (auto result = w.stream->commit(); !result.has_value()) {
+					return result;
+				}
+			}
+
+			// the array stays open like after start_array(), end_array() closes it
+			w.stack.emplace(nullptr, JsonWriter::Level::kArray).count = static_cast<uint32_t>(count);
+			return {};
+		}
+
+		// values JSON has no text for, checked before either mode writes anything
+		template<typename T>
+		static std::expected<void, JsonErrorCode> check_value(const T& value) noexcept {
+			if constexpr (std::is_floating_point_v<T>) {
+				if (!std::isfinite(value)) {
+					return std::unexpected(JsonErrorCode::UnknownError);
+				}
+			} else if constexpr (std::is_same_v<T, JsonRawNumber>) {
+				// raw text is copied as it is, so it has to be exactly one number
+				const char8_t* error = nullptr;
+				const char8_t* end = value.text + value.length;
+				if (value.length == 0 || json_text::number_end(value.text, end, error) != end) {
+					return std::unexpected(JsonErrorCode::UnknownError);
+				}
+			}
+			return {};
+		}
+
+		template<typename T>
+		static std::expected<void, JsonErrorCode> check_values(size_t count, const T* values) noexcept {
+			for (size_t i = 0; i < count; i++) {
+				if (auto result = check_value(values[i]); !result.has_value()) {
+					return result;
+				}
+			}
+			return {};
+		}
+
+		template<typename T, typename... Args>
+		static std::expected<void, JsonErrorCode> write(JsonWriter& w, u8string_view key, T value, Args&&... args) {
+			using enum JsonErrorCode;
+
+			if (w.stack.empty()) {
+				return std::unexpected(NoOpenScope);
+			}
+			if (auto result = check_value(value); !result.has_value()) {
+				return result;
+			}
+
+			if (w.stream) {
+				return stream_write(w, key, value, std::forward<Args>(args)...);
+			}
+
+			const auto level = w.stack.top();
+			if (auto result = check_key(level, key); !result.has_value()) {
+				return result;
+			}
+
+			if (attach(w, level, key, make_value(w, value, std::forward<Args>(args)...))) {
+				return {};
+			}
+			return std::unexpected(UnknownError);
+		}
+
+		template<typename T, typename... Args>
+		static yyjson_mut_val* make_value(const JsonWriter& w, T value, Args&&... args) {
+			if constexpr (std::is_same_v<T, bool>) {
+				return yyjson_mut_bool(w.document, value);
+			} else if constexpr (std::is_same_v<T, int64_t>) {
+				return yyjson_mut_sint(w.document, value);
+			} else if constexpr (std::is_same_v<T, uint64_t>) {
+				return yyjson_mut_uint(w.document, value);
+			} else if constexpr (std::is_floating_point_v<T>) {
+				return yyjson_mut_real(w.document, value);
+			} else if constexpr (std::is_same_v<T, JsonRawNumber>) {
+				return yyjson_mut_rawncpy(w.document, reinterpret_cast<const char*>(value.text), value.length);
+			} else {
+				return yyjson_mut_strncpy(w.document, value, std::forward<Args>(args)...);
+			}
+		}
+
+		// the object of a JsonFields type is on top of the stack, so only the member itself is added
+		template<typename T, typename... Args>
+		static std::expected<void, JsonErrorCode> write_field(JsonWriter& w, const JsonStaticKey& key, T value, Args&&... args) {
+			if (auto result = check_value(value); !result.has_value()) {
+				return result;
+			}
+
+			if (w.stream) {
+				return stream_write(w, key.view(), value, std::forward<Args>(args)...);
+			}
+
+			// static keys outlive the document and are referenced
+			yyjson_mut_val* k = yyjson_mut_strn(w.document, reinterpret_cast<const char*>(key.view().data()), key.view().size());
+			yyjson_mut_val* val = make_value(w, value, std::forward<Args>(args)...);
+			if (k && val && yyjson_mut_obj_add(w.stack.top().value, k, val)) {
+				return {};
+			}
+			return std::unexpected(JsonErrorCode::UnknownError);
+		}
+
+		template<typename T, typename... Args>
+		static std::expected<void, JsonErrorCode> write_array(JsonWriter& w, size_t count, u8string_view key, T&& values, Args&&... args) {
+			using enum JsonErrorCode;
+
+			using U = std::decay_t<T>;
+
+			if (w.stack.empty()) {
+				return std::unexpected(NoOpenScope);
+			}
+			if (auto result = check_values(count, values); !result.has_value()) {
+				return result;
+			}
+
+			if (w.stream) {
+				return stream_write_array(w, count, key, values, args...);
+			}
+
+			const auto level = w.stack.top();
+			if (auto result = check_key(level, key); !result.has_value()) {
+				return result;
+			}
+
+			// each of these but float fills the array from one allocation of count values
+			yyjson_mut_val* arr = nullptr;
+			if constexpr (std::is_same_v<U, const bool*>) {
+				arr = ::yyjson_mut_arr_with_bool(w.document, values, count);
+			} else if constexpr (std::is_same_v<U, const int8_t*>) {
+				arr = ::yyjson_mut_arr_with_sint8(w.document, values, count);
+			} else if constexpr (std::is_same_v<U, const int16_t*>) {
+				arr = ::yyjson_mut_arr_with_sint16(w.document, values, count);
+			} else if constexpr (std::is_same_v<U, const int32_t*>) {
+				arr = ::yyjson_mut_arr_with_sint32(w.document, values, count);
+			} else if constexpr (std::is_same_v<U, const int64_t*>) {
+				arr = ::yyjson_mut_arr_with_sint64(w.document, values, count);
+			} else if constexpr (std::is_same_v<U, const uint8_t*>) {
+				arr = ::yyjson_mut_arr_with_uint8(w.document, values, count);
+			} else if constexpr (std::is_same_v<U, const uint16_t*>) {
+				arr = ::yyjson_mut_arr_with_uint16(w.document, values, count);
+			} else if constexpr (std::is_same_v<U, const uint32_t*>) {
+				arr = ::yyjson_mut_arr_with_uint32(w.document, values, count);
+			} else if constexpr (std::is_same_v<U, const uint64_t*>) {
+				arr = ::yyjson_mut_arr_with_uint64(w.document, values, count);
+			} else if constexpr (std::is_same_v<U, const float*>) {
+				// yyjson_mut_arr_with_float keeps float precision and prints shorter digits than stream mode,
+				// widen each value like single float writes do
+				arr = ::yyjson_mut_arr(w.document);
+				for (size_t i = 0; arr && i < count; i++) {
+					if (!::yyjson_mut_arr_add_real(w.document, arr, static_cast<double>(values[i]))) {
+						arr = nullptr;
+					}
+				}
+			} else if constexpr (std::is_same_v<U, const double*>) {
+				arr = ::yyjson_mut_arr_with_real(w.document, values, count);
+			} else {
+				arr = ::yyjson_mut_arr_with_strncpy(w.document, values, std::forward<Args>(args)..., count);
+			}
+
+			if (attach(w, level, key, arr)) {
+				w.stack.emplace(reinterpret_cast<JsonWriterValue*>(arr), JsonWriter::Level::kArray);
+				return {};
+			}
+			return std::unexpected(UnknownError);
+		}
+
+		static std::expected<size_t, JsonErrorCode> lazy_cursor(JsonLazyDocument& d, JsonLazyDocument::Level& level) noexcept {
+			if (level.pending != JsonScanner::npos) {
+				const size_t end = d.scanner.skip_value(level.pending);
+				level.cursor = end == JsonScanner::npos ? end : d.scanner.next_member(end);
+				level.pending = JsonScanner::npos;
+			}
+
+			if (level.cursor == JsonScanner::npos) {
+				return std::unexpected(JsonErrorCode::ParseFailed);
+			}
+			return level.cursor;
+		}
+
+		// members are scanned from the cursor on and wrap around to the first one
+		static std::expected<size_t, JsonErrorCode> lazy_find_member(JsonLazyDocument& d, JsonLazyDocument::Level& level, u8string_view key) {
+			using enum JsonErrorCode;
+			const auto& scanner = d.scanner;
+
+			auto start = lazy_cursor(d, level);
+			if (!start.has_value()) {
+				return start;
+			}
+
+			size_t pos = start.value();
+			bool wrapped = false;
+			while (!wrapped || pos != start.value()) {
+				if (scanner.at(pos) == u8'}') {
+					level.end = pos + 1;
+					if (wrapped) {
+						break;
+					}
+					wrapped = true;
+					pos = level.begin;
+					continue;
+				}
+
+				if (scanner.at(pos) != u8'"') {
+					return std::unexpected(ParseFailed);
+				}
+
+				size_t key_end;
+				const bool match = scanner.string_equals(pos, key, d.scratch, key_end);
+				if (key_end == JsonScanner::npos) {
+					return std::unexpected(ParseFailed);
+				}
+
+				const size_t colon = scanner.skip_whitespace(key_end);
+				if (scanner.at(colon) != u8':') {
+					return std::unexpected(ParseFailed);
+				}
+
+				const size_t value = scanner.skip_whitespace(colon + 1);
+				if (match) {
+					return value;
+				}
+
+				pos = scanner.skip_value(value);
+				if (pos != JsonScanner::npos) {
+					pos = scanner.next_member(pos);
+				}
+				if (pos == JsonScanner::npos) {
+					return std::unexpected(ParseFailed);
+				}
+			}
+			return std::unexpected(KeyNotFound);
+		}
+
+		// position of the value addressed by key in the innermost scope
+		static std::expected<size_t, JsonErrorCode> lazy_locate(JsonReader& r, u8string_view key) {
+			using enum JsonErrorCode;
+
+			auto& d = *r.lazy;
+			auto& level = d.stack.back();
+			if (r.stack.top().type == JsonReader::Level::kObject) {
+				if (key.empty()) {
+					return std::unexpected(EmptyObjectFieldKey);
+				}
+				return lazy_find_member(d, level, key);
+			}
+
+			if (!key.empty()) {
+				return std::unexpected(ArrayElementWithKey);
+			}
+
+			auto pos = lazy_cursor(d, level);
+			if (pos.has_value() && d.scanner.at(pos.value()) == u8']') {
+				level.end = pos.value() + 1;
+				return std::unexpected(KeyNotFound);
+			}
+			return pos;
+		}
+
+		// returns the number of elements when an array is opened
+		static std::expected<size_t, JsonErrorCode> lazy_start(JsonReader& r, u8string_view key, JsonReader::Level::EType type) {
+			using enum JsonErrorCode;
+
+			auto& d = *r.lazy;
+			const auto& scanner = d.scanner;
+
+			size_t pos;
+			if (r.stack.empty()) {
+				if (type == JsonReader::Level::kArray) {
+					return std::unexpected(NoOpenScope);
+				}
+				if (!key.empty()) {
+					return std::unexpected(RootObjectWithKey);
+				}
+				pos = scanner.skip_whitespace(0);
+			} else {
+				auto found = lazy_locate(r, key);
+				if (!found.has_value()) {
+					return found;
+				}
+				pos = found.value();
+				d.stack.back().pending = pos;
+			}
+
+			if (scanner.at(pos) != (type == JsonReader::Level::kObject ? u8'{' : u8'[')) {
+				return std::unexpected(ScopeTypeMismatch);
+			}
+
+			JsonLazyDocument::Level level;
+			level.begin = level.cursor = scanner.skip_whitespace(pos + 1);
+
+			// the size of an array is only known by skipping all of its elements
+			size_t count = 0;
+			if (type == JsonReader::Level::kArray) {
+				size_t element = level.begin;
+				while (scanner.at(element) != u8']') {
+					element = scanner.skip_value(element);
+					if (element != JsonScanner::npos) {
+						element = scanner.next_member(element);
+					}
+					if (element == JsonScanner::npos) {
+						return std::unexpected(ParseFailed);
+					}
+					count++;
+				}
+				level.end = element + 1;
+			}
+
+			d.stack.push_back(level);
+			r.stack.emplace(nullptr, type);
+			return count;
+		}
+
+		// the parent continues behind the closed scope if its end is known, otherwise it skips it on the next access
+		static void lazy_end(JsonReader& r) noexcept {
+			auto& d = *r.lazy;
+			const auto& child = d.stack.back();
+
+			size_t end = child.end;
+			if (end == JsonScanner::npos && child.pending == JsonScanner::npos && (d.scanner.at(child.cursor) == u8'}' || d.scanner.at(child.cursor) == u8']')) {
+				end = child.cursor + 1;
+			}
+
+			d.stack.pop_back();
+			if (!d.stack.empty() && end != JsonScanner::npos) {
+				auto& parent = d.stack.back();
+				parent.cursor = d.scanner.next_member(end);
+				parent.pending = JsonScanner::npos;
+			}
+		}
+
+		// mismatched types read as zero, like yyjson_get_*
+		template<typename T>
+		static std::expected<void, JsonErrorCode> lazy_read(JsonReader& r, u8string_view key, T& value) {
+			using enum JsonErrorCode;
+
+			auto pos = lazy_locate(r, key);
+			if (!pos.has_value()) {
+				return std::unexpected(pos.error());
+			}
+
+			auto& d = *r.lazy;
+			const auto& scanner = d.scanner;
+			const size_t begin = pos.value();
+			const size_t end = scanner.skip_value(begin);
+			if (end == JsonScanner::npos) {
+				return std::unexpected(ParseFailed);
+			}
+
+			if constexpr (std::is_same_v<T, bool>) {
+				value = end - begin == 4 && std::memcmp(scanner.data() + begin, u8"true", 4) == 0;
+			} else if constexpr (std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t> || std::is_same_v<T, double>) {
+				if (auto result = take_number(scanner.read_number(begin, end), value); !result.has_value()) {
+					return result;
+				}
+			} else if constexpr (std::is_same_v<T, JsonRawNumber>) {
+				const char8_t c = scanner.at(begin);
+				if (c != u8'-' && (c < u8'0' || c > u8'9')) {
+					return std::unexpected(ElementTypeMismatch);
+				}
+				value = {scanner.data() + begin, end - begin};
+			} else {
+				value = {};
+				if (scanner.at(begin) == u8'"') {
+					// strings of the previous read are dropped, so reading the same field over and over stays in one block
+					d.strings.rewind();
+					auto str = lazy_string(d, begin);
+					if (str.has_value() && std::is_same_v<T, const char*> && str->data() == scanner.data() + begin + 1) {
+						// the input has no terminator behind the content
+						str = lazy_copy(d, str.value());
+					}
+					if (!str.has_value()) {
+						return std::unexpected(str.error());
+					}
+					if constexpr (std::is_same_v<T, u8string_view>) {
+						value = str.value();
+					} else {
+						value = reinterpret_cast<const char*>(str->data());
+					}
+				}
+			}
+
+			d.stack.back().cursor = scanner.next_member(end);
+			return {};
+		}
+
+		// content of the string at pos, a view into the input unless it has escapes, those are unescaped into strings
+		static std::expected<u8string_view, JsonErrorCode> lazy_string(JsonLazyDocument& d, size_t pos) {
+			const size_t end = d.scanner.skip_string(pos);
+			if (end == JsonScanner::npos) {
+				return std::unexpected(JsonErrorCode::ParseFailed);
+			}
+
+			const char8_t* content = d.scanner.data() + pos + 1;
+			const size_t raw_length = end - pos - 2;
+			if (std::memchr(content, u8'\\', raw_length) == nullptr) {
+				return u8string_view{content, raw_length};
+			}
+
+			d.scratch.clear();
+			if (d.scanner.read_string(pos, d.scratch) == JsonScanner::npos) {
+				return std::unexpected(JsonErrorCode::ParseFailed);
+			}
+			return lazy_copy(d, {d.scratch.data(), d.scratch.size()});
+		}
+
+		// null terminated copy in strings
+		static std::expected<u8string_view, JsonErrorCode> lazy_copy(JsonLazyDocument& d, u8string_view text) {
+			auto str = static_cast<char8_t*>(d.strings.allocate(text.size() + 1));
+			if (!str) {
+				return std::unexpected(JsonErrorCode::UnknownError);
+			}
+			std::memcpy(str, text.data(), text.size());
+			str[text.size()] = u8'\0';
+			return u8string_view{str, text.size()};
+		}
 
-	struct JsonReaderDocument : yyjson_doc {};
+		static u8string_view step_key(const JsonPath& path, const JsonPath::Step& step) noexcept {
+			return {path.keys.data() + step.offset, step.length};
+		}
 
-	struct JsonReaderValue : yyjson_val {};
+		static bool same_step(const JsonPath& a, const JsonPath& b, size_t i) noexcept {
+			const auto& x = a.steps[i];
+			const auto& y = b.steps[i];
+			return x.hash == y.hash && x.length == y.length && (x.length == 0 || std::memcmp(a.keys.data() + x.offset, b.keys.data() + y.offset, x.length) == 0);
+		}
 
-	const char* CStringBuild(yyjson_mut_doc* doc, u8string_view sv) {
-		return yyjson_mut_get_str(yyjson_mut_strncpy(doc, reinterpret_cast<const char*>(sv.data()), sv.size()));
-	}
+		// nullptr when the step leads nowhere
+		static std::expected<yyjson_val*, JsonErrorCode> path_step(JsonReader& r, yyjson_val* val, const JsonPath& path, const JsonPath::Step& step) {
+			if (yyjson_is_obj(val)) {
+				const u8string_view key = step_key(path, step);
+				if (yyjson_obj_size(val) <= r.key_index_threshold) {
+					return yyjson_obj_getn(val, reinterpret_cast<const char*>(key.data()), key.size());
+				}
+				if (!r.key_index) {
+					r.key_index = new JsonKeyIndex;
+				}
+				// paths from the open scope share its table with read()
+				if (!r.stack.empty() && r.stack.top().value == val) {
+					auto& level = r.stack.top();
+					if (level.key_table == 0) {
+						level.key_table = r.key_index->find_table(val);
+					}
+					return r.key_index->find(level.key_table, key, step.hash);
+				}
+				return r.key_index->find(r.key_index->find_table(val), key, step.hash);
+			}
+			if (yyjson_is_arr(val) && step.index != SIZE_MAX) {
+				return yyjson_arr_get(val, step.index);
+			}
+			return nullptr;
+		}
 
-	struct JsonImpl {
-		template<typename T, typename... Args>
-		static std::expected<void, JsonErrorCode> write(const JsonWriter& w, u8string_view key, T value, Args&&... args) {
+		static std::expected<JsonPathValue, JsonErrorCode> path_value(JsonReader&, yyjson_val* val) noexcept {
+			JsonPathValue value;
+			if (yyjson_is_null(val)) {
+				value.type = JsonPathValue::kNull;
+			} else if (yyjson_is_bool(val)) {
+				value.type = JsonPathValue::kBool;
+				value.boolean = yyjson_get_bool(val);
+			} else if (yyjson_is_num(val) || yyjson_is_raw(val)) {
+				const auto number = element_number(val);
+				if (number.type == JsonScanNumber::kUint) {
+					value.type = JsonPathValue::kUint;
+					value.uint = number.uint;
+				} else if (number.type == JsonScanNumber::kSint) {
+					value.type = JsonPathValue::kSint;
+					value.sint = number.sint;
+				} else {
+					value.type = JsonPathValue::kReal;
+					value.real = number.real;
+				}
+			} else if (yyjson_is_str(val)) {
+				value.type = JsonPathValue::kString;
+				value.string = reinterpret_cast<const char8_t*>(yyjson_get_str(val));
+				value.length = yyjson_get_len(val);
+			} else if (yyjson_is_arr(val)) {
+				value.type = JsonPathValue::kArray;
+			} else if (yyjson_is_obj(val)) {
+				value.type = JsonPathValue::kObject;
+			}
+			return value;
+		}
+
+		// npos when the step leads nowhere
+		static std::expected<size_t, JsonErrorCode> lazy_path_step(JsonReader& r, size_t pos, const JsonPath& path, const JsonPath::Step& step) {
 			using enum JsonErrorCode;
-			using enum JsonWriter::Level::EType;
+			auto& d = *r.lazy;
+			const auto& scanner = d.scanner;
 
-			if (w.stack.empty()) {
-				return std::unexpected(NoOpenScope);
+			const char8_t open = scanner.at(pos);
+			if (open != u8'{' && (open != u8'[' || step.index == SIZE_MAX)) {
+				return JsonScanner::npos;
 			}
 
-			const auto level = w.stack.back();
-			bool success = false;
+			size_t element = scanner.skip_whitespace(pos + 1);
+			for (size_t i = 0;; i++) {
+				if (scanner.at(element) == (open == u8'{' ? u8'}' : u8']')) {
+					return JsonScanner::npos;
+				}
 
-			if (level.type == kObject) {
-				if (key.empty()) {
-					return std::unexpected(EmptyObjectFieldKey);
+				size_t value = element;
+				if (open == u8'{') {
+					if (scanner.at(element) != u8'"') {
+						return std::unexpected(ParseFailed);
+					}
+
+					size_t key_end;
+					const bool match = scanner.string_equals(element, step_key(path, step), d.scratch, key_end);
+					if (key_end == JsonScanner::npos) {
+						return std::unexpected(ParseFailed);
+					}
+
+					const size_t colon = scanner.skip_whitespace(key_end);
+					if (scanner.at(colon) != u8':') {
+						return std::unexpected(ParseFailed);
+					}
+					value = scanner.skip_whitespace(colon + 1);
+					if (match) {
+						return value;
+					}
+				} else if (i == step.index) {
+					return value;
 				}
-				const char* ckey = CStringBuild(w.document, key);
 
-				if constexpr (std::is_same_v<T, bool>) {
-					success = yyjson_mut_obj_add_bool(w.document, level.value, ckey, value);
-				} else if constexpr (std::is_same_v<T, int64_t>) {
-					success = yyjson_mut_obj_add_sint(w.document, level.value, ckey, value);
-				} else if constexpr (std::is_same_v<T, uint64_t>) {
-					success = yyjson_mut_obj_add_uint(w.document, level.value, ckey, value);
-				} else if constexpr (std::is_floating_point_v<T>) {
-					success = yyjson_mut_obj_add_real(w.document, level.value, ckey, value);
-				} else {
-					success = yyjson_mut_obj_add_strncpy(w.document, level.value, ckey, value, std::forward<Args>(args)...);
+				element = scanner.skip_value(value);
+				if (element != JsonScanner::npos) {
+					element = scanner.next_member(element);
 				}
-			} else if (level.type == kArray) {
-				if (!key.empty()) {
-					return std::unexpected(ArrayElementWithKey);
+				if (element == JsonScanner::npos) {
+					return std::unexpected(ParseFailed);
 				}
+			}
+		}
 
-				if constexpr (std::is_same_v<T, bool>) {
-					success = yyjson_mut_arr_add_bool(w.document, level.value, value);
-				} else if constexpr (std::is_same_v<T, int64_t>) {
-					success = yyjson_mut_arr_add_sint(w.document, level.value, value);
-				} else if constexpr (std::is_same_v<T, uint64_t>) {
-					success = yyjson_mut_arr_add_uint(w.document, level.value, value);
-				} else if constexpr (std::is_floating_point_v<T>) {
-					success = yyjson_mut_arr_add_real(w.document, level.value, value);
-				} else {
-					success = yyjson_mut_arr_add_strncpy(w.document, level.value, value, std::forward<Args>(args)...);
+		static std::expected<JsonPathValue, JsonErrorCode> lazy_path_value(JsonReader& r, size_t pos) {
+			using enum JsonErrorCode;
+			auto& d = *r.lazy;
+			const auto& scanner = d.scanner;
+
+			JsonPathValue value;
+			const size_t end = scanner.skip_value(pos);
+			if (end == JsonScanner::npos) {
+				return std::unexpected(ParseFailed);
+			}
+
+			switch (scanner.at(pos)) {
+				case u8'{': value.type = JsonPathValue::kObject;
+					break;
+				case u8'[': value.type = JsonPathValue::kArray;
+					break;
+				case u8'n': value.type = JsonPathValue::kNull;
+					break;
+				case u8't':
+				case u8'f':
+					value.type = JsonPathValue::kBool;
+					value.boolean = scanner.at(pos) == u8't';
+					break;
+				case u8'"': {
+					auto str = lazy_string(d, pos);
+					if (!str.has_value()) {
+						return std::unexpected(str.error());
+					}
+					value.type = JsonPathValue::kString;
+					value.string = str->data();
+					value.length = str->size();
+					break;
+				}
+				default: {
+					const auto number = scanner.read_number(pos, end);
+					if (number.type == JsonScanNumber::kSint) {
+						value.type = JsonPathValue::kSint;
+						value.sint = number.sint;
+					} else if (number.type == JsonScanNumber::kUint) {
+						value.type = JsonPathValue::kUint;
+						value.uint = number.uint;
+					} else if (number.type == JsonScanNumber::kReal) {
+						value.type = JsonPathValue::kReal;
+						value.real = number.real;
+					} else {
+						return std::unexpected(ParseFailed);
+					}
+					break;
+				}
+			}
+			return value;
+		}
+
+		// the open scope is remembered by its first member, its bracket is the last byte before that which is no whitespace
+		static size_t lazy_scope_start(JsonReader& r) noexcept {
+			const auto& scanner = r.lazy->scanner;
+			if (r.stack.empty()) {
+				return scanner.skip_whitespace(0);
+			}
+
+			size_t pos = r.lazy->stack.back().begin;
+			do {
+				pos--;
+			} while (pos > 0 && scanner.at(pos) != u8'{' && scanner.at(pos) != u8'[');
+			return pos;
+		}
+
+		template<typename Node>
+		static std::expected<JsonPathValue, JsonErrorCode> resolve_path(JsonReader& r, const JsonPath& path, Node node, Node missing, auto&& step, auto&& value) {
+			for (const auto& s : path.steps) {
+				auto next = step(r, node, path, s);
+				if (!next.has_value()) {
+					return std::unexpected(next.error());
+				}
+				if (next.value() == missing) {
+					return std::unexpected(JsonErrorCode::KeyNotFound);
+				}
+				node = next.value();
+			}
+			return value(r, node);
+		}
+
+		template<typename Node>
+		static std::expected<void, JsonErrorCode> resolve_paths(JsonReader& r, std::span<const JsonPath> paths, std::span<JsonPathValue> values, Node start, Node missing,
+		                                                        auto&& step, auto&& value) {
+			// sorted paths put shared prefixes next to each other
+			std::vector<uint32_t> order(paths.size());
+			for (uint32_t i = 0; i < order.size(); i++) {
+				order[i] = i;
+			}
+			std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+				const JsonPath& x = paths[a];
+				const JsonPath& y = paths[b];
+				return std::lexicographical_compare(x.steps.begin(), x.steps.end(), y.steps.begin(), y.steps.end(), [&](const auto& s, const auto& t) {
+					const size_t common = std::min(s.length, t.length);
+					const int order = common ? std::memcmp(x.keys.data() + s.offset, y.keys.data() + t.offset, common) : 0;
+					return order < 0 || (order == 0 && s.length < t.length);
+				});
+			});
+
+			// nodes[k] is where the first k steps of the previous path led
+			std::vector<Node> nodes{start};
+			const JsonPath* previous = nullptr;
+			for (uint32_t i : order) {
+				const JsonPath& path = paths[i];
+				size_t depth = 0;
+				while (previous && depth < path.size() && depth + 1 < nodes.size() && same_step(*previous, path, depth)) {
+					depth++;
+				}
+				nodes.resize(depth + 1);
+				previous = &path;
+
+				while (nodes.size() <= path.size() && nodes.back() != missing) {
+					auto next = step(r, nodes.back(), path, path.steps[nodes.size() - 1]);
+					if (!next.has_value()) {
+						return std::unexpected(next.error());
+					}
+					nodes.push_back(next.value());
 				}
+
+				values[i] = JsonPathValue{};
+				if (nodes.back() == missing) {
+					nodes.pop_back();
+				} else if (nodes.size() == path.size() + 1) {
+					auto result = value(r, nodes.back());
+					if (!result.has_value()) {
+						return std::unexpected(result.error());
+					}
+					values[i] = result.value();
+				}
+			}
+			return {};
+		}
+
+		static std::expected<JsonPathValue, JsonErrorCode> resolve(JsonReader& r, const JsonPath& path) {
+			if (r.lazy) {
+				// escaped strings of the previous call are dropped, repeated lookups reuse the same block
+				r.lazy->strings.rewind();
+				return resolve_path<size_t>(r, path, lazy_scope_start(r), JsonScanner::npos, lazy_path_step, lazy_path_value);
+			}
+			yyjson_val* start = r.stack.empty() ? yyjson_doc_get_root(r.document) : r.stack.top().value;
+			if (!start) {
+				return std::unexpected(JsonErrorCode::KeyNotFound);
+			}
+			return resolve_path<yyjson_val*>(r, path, start, nullptr, path_step, path_value);
+		}
+
+		static std::expected<void, JsonErrorCode> resolve(JsonReader& r, std::span<const JsonPath> paths, std::span<JsonPathValue> values) {
+			if (values.size() < paths.size()) {
+				return std::unexpected(JsonErrorCode::BufferTooSmall);
+			}
+
+			if (r.lazy) {
+				r.lazy->strings.rewind();
+				return resolve_paths<size_t>(r, paths, values, lazy_scope_start(r), JsonScanner::npos, lazy_path_step, lazy_path_value);
 			}
-			if (success) {
+			yyjson_val* start = r.stack.empty() ? yyjson_doc_get_root(r.document) : r.stack.top().value;
+			if (!start) {
+				std::fill(values.begin(), values.begin() + paths.size(), JsonPathValue{});
 				return {};
 			}
-			return std::unexpected(UnknownError);
+			return resolve_paths<yyjson_val*>(r, paths, values, start, nullptr, path_step, path_value);
 		}
 
-		template<typename T, typename... Args>
-		static std::expected<void, JsonErrorCode> write_array(JsonWriter& w, size_t count, u8string_view key, T&& values, Args&&... args) {
-			using enum JsonErrorCode;
-			using enum JsonWriter::Level::EType;
+		// move the unconsumed tail to the front and read behind it, the buffer only grows when one record fills it
+		static std::expected<void, JsonErrorCode> fill(NdjsonInput& in, JsonSource& source) {
+			const size_t pending = in.end - in.begin;
+			if (in.begin > 0) {
+				std::memmove(in.data.get(), in.data.get() + in.begin, pending);
+				in.scanned -= in.begin;
+				in.begin = 0;
+				in.end = pending;
+			}
 
-			using U = std::decay_t<T>;
+			if (in.end == in.capacity) {
+				auto data = std::make_unique_for_overwrite<char8_t[]>(in.capacity * 2);
+				std::memcpy(data.get(), in.data.get(), in.end);
+				in.data = std::move(data);
+				in.capacity *= 2;
+			}
 
-			if (w.stack.empty()) {
-				return std::unexpected(NoOpenScope);
+			size_t size = 0;
+			if (!source.read(in.data.get() + in.end, in.capacity - in.end, size)) {
+				return std::unexpected(JsonErrorCode::FileIOFailed);
 			}
-			yyjson_mut_val* arr = nullptr;
+			in.end += size;
+			in.eof = size == 0;
+			return {};
+		}
 
-			if constexpr (std::is_same_v<U, const bool*>) {
-				arr = ::yyjson_mut_arr_with_bool(w.document, values, count);
-			} else if constexpr (std::is_same_v<U, const int64_t*>) {
-				arr = ::yyjson_mut_arr_with_sint64(w.document, values, count);
-			} else if constexpr (std::is_same_v<U, const uint64_t*>) {
-				arr = ::yyjson_mut_arr_with_uint64(w.document, values, count);
-			} else if constexpr (std::is_same_v<U, const double*>) {
-				arr = ::yyjson_mut_arr_with_real(w.document, values, count);
-			} else {
-				arr = ::yyjson_mut_arr_with_strncpy(w.document, values, std::forward<Args>(args)..., count);
+		// calls f(offset, length) for every non-blank line of data in [begin, end)
+		template<typename F>
+		static void for_each_record(const char8_t* data, size_t begin, size_t end, F&& f) {
+			while (begin < end) {
+				auto newline = static_cast<const char8_t*>(std::memchr(data + begin, u8'\n', end - begin));
+				const size_t line_end = newline ? newline - data : end;
+				if (JsonScanner{data, line_end}.skip_whitespace(begin) < line_end) {
+					f(begin, line_end - begin);
+				}
+				begin = line_end + 1;
 			}
+		}
 
-			const auto level = w.stack.back();
-			bool success = false;
+		static std::expected<void, JsonErrorCode> parse_parallel(u8string_view input, NdjsonCallback callback, void* context, const NdjsonParallelOptions& options) {
+			const char8_t* data = input.data();
+			const size_t size = input.size();
 
-			if (level.type == kArray) {
-				if (!key.empty()) {
-					return std::unexpected(ArrayElementWithKey);
+			std::vector<size_t> bounds{0};
+			while (bounds.back() < size) {
+				size_t pos = bounds.back() + std::max<size_t>(options.chunk_size, 1);
+				if (pos < size) {
+					auto newline = static_cast<const char8_t*>(std::memchr(data + pos, u8'\n', size - pos));
+					pos = newline ? newline - data + 1 : size;
+				}
+				bounds.push_back(std::min(pos, size));
+			}
+
+			const size_t chunks = bounds.size() - 1;
+			const size_t threads = std::min<size_t>(options.threads ? options.threads : std::max(std::thread::hardware_concurrency(), 1u), std::max<size_t>(chunks, 1));
+
+			std::atomic<size_t> next_chunk = 0;
+			std::atomic<bool> failed = false;
+			std::atomic<bool> stopped = false;
+			std::mutex mutex;
+			std::condition_variable turn;
+			size_t delivered = 0;
+			// exceptions of the callback, rethrown once every worker is joined
+			std::vector<std::exception_ptr> exceptions(threads);
+			// earliest record that failed, its error is relative to the record until the end
+			JsonParseError first_error;
+			size_t first_record = std::numeric_limits<size_t>::max();
+
+			auto record_failure = [&](const JsonReader& reader, size_t offset) {
+				failed = true;
+				std::lock_guard lock(mutex);
+				if (offset < first_record) {
+					first_record = offset;
+					first_error = *reader.failure;
+				}
+			};
+
+			auto work = [&] {
+				// ordered delivery keeps the documents of a chunk until all chunks before it are delivered
+				// declared first, a callback that throws leaves one of them in reader
+				JsonArena documents_arena;
+				JsonReader reader(JsonReadMode::Document);
+				std::vector<std::pair<yyjson_doc*, size_t>> documents;
+
+				for (size_t chunk; !stopped && (chunk = next_chunk.fetch_add(1)) < chunks;) {
+					if (!options.ordered) {
+						for_each_record(data, bounds[chunk], bounds[chunk + 1], [&](size_t offset, size_t length) {
+							reader.reset(u8string_view{data + offset, length});
+							if (reader.document) {
+								callback(context, reader, offset);
+							} else {
+								record_failure(reader, offset);
+							}
+						});
+						continue;
+					}
+
+					// same parse as JsonReader::reset(), only into memory that outlives the next record
+					const auto alc = documents_arena.allocator();
+					for_each_record(data, bounds[chunk], bounds[chunk + 1], [&](size_t offset, size_t length) {
+						if (auto doc = parse_document(reader, alc, const_cast<char8_t*>(data + offset), length, 0)) {
+							documents.emplace_back(doc, offset);
+						} else {
+							record_failure(reader, offset);
+						}
+					});
+
+					std::unique_lock lock(mutex);
+					turn.wait(lock, [&] { return delivered == chunk || stopped; });
+					if (stopped) {
+						break;
+					}
+					lock.unlock();
+
+					// freeing through the arena allocator is a no-op, the documents go away with the rewind
+					for (auto [doc, offset] : documents) {
+						clear(reader);
+						reader.document = reinterpret_cast<JsonReaderDocument*>(doc);
+						callback(context, reader, offset);
+					}
+					clear(reader);
+					documents.clear();
+					documents_arena.rewind();
+
+					lock.lock();
+					delivered++;
+					lock.unlock();
+					turn.notify_all();
+				}
+			};
+
+			// a throwing callback stops the others, ordered workers waiting for its chunk included
+			auto worker = [&](size_t index) {
+				try {
+					work();
+				} catch (...) {
+					exceptions[index] = std::current_exception();
+					std::lock_guard lock(mutex);
+					stopped = true;
+					turn.notify_all();
 				}
+			};
+
+			{
+				// joined on the way out, whatever happens in between
+				std::vector<std::jthread> pool;
+				pool.reserve(threads - 1);
+				for (size_t i = 1; i < threads; i++) {
+					pool.emplace_back(worker, i);
+				}
+				worker(0);
+			}
 
-				success = yyjson_mut_arr_add_val(level.value, arr);
-			} else if (level.type == kObject) {
-				if (key.empty()) {
-					return std::unexpected(EmptyObjectFieldKey);
+			for (auto& exception : exceptions) {
+				if (exception) {
+					std::rethrow_exception(exception);
 				}
-				const char* ckey = CStringBuild(w.document, key);
-				success = yyjson_mut_obj_add_val(w.document, level.value, ckey, arr);
 			}
 
-			if (success) {
-				w.stack.emplace_back(reinterpret_cast<JsonWriterValue*>(arr), kArray);
-				return {};
+			if (failed) {
+				if (options.error) {
+					// records start at a line start, only the line needs the lines before the record
+					*options.error = first_error;
+					options.error->offset += first_record;
+					if (first_error.line) {
+						options.error->line += std::count(data, data + first_record, u8'\n');
+					}
+				}
+				return std::unexpected(JsonErrorCode::ParseFailed);
 			}
-			return std::unexpected(UnknownError);
+			return {};
+		}
+
+		// scan the buffered bytes from begin on, the document is parsed in one go as soon as its end shows up
+		static std::expected<bool, JsonErrorCode> scan_framed(JsonDocumentFramer& r, size_t begin) {
+			auto& in = *r.input;
+			const size_t end = in.scanner.advance(in.buffer.data(), begin, in.buffer.size());
+			if (end == JsonBoundaryScanner::npos) {
+				return false;
+			}
+
+			// what follows the document belongs to the next one, the room behind it becomes the padding of in situ parsing
+			in.pending.append(in.buffer.data() + end, in.buffer.size() - end);
+			char8_t* text = in.buffer.reserve(JsonReader::insitu_padding) - in.buffer.size();
+			clear(r.document);
+			parse(r.document, std::span<char8_t>{text, end + JsonReader::insitu_padding}, end);
+			in.complete = true;
+
+			if (!r.document.document) {
+				return std::unexpected(JsonErrorCode::ParseFailed);
+			}
+			return true;
+		}
+
+		static void clear(JsonReader& r) noexcept {
+			r.stack.clear();
+			if (r.failure) {
+				r.failure->offset = JsonParseError::no_error;
+			}
+
+			if (r.lazy) {
+				r.lazy->stack.clear();
+				r.lazy->strings.rewind();
+				r.lazy->validity = JsonLazyDocument::kUnchecked;
+			}
+
+			yyjson_doc_free(r.document);
+			r.document = nullptr;
+			if (r.key_index) {
+				r.key_index->clear();
+			}
+			if (r.arena) {
+				r.arena->rewind();
+			}
+		}
+
+		// parse with the flags of r into memory of alc, a failure is recorded in r.failure
+		static yyjson_doc* parse_document(JsonReader& r, const yyjson_alc& alc, char8_t* json, size_t len, yyjson_read_flag flags) {
+			yyjson_read_err err = {};
+			if (r.raw_numbers) {
+				flags |= YYJSON_READ_NUMBER_AS_RAW;
+			}
+			auto doc = yyjson_read_opts(reinterpret_cast<char*>(json), len, flags, &alc, &err);
+			if (doc == nullptr) {
+				fail(r, json, len, err);
+			}
+			return doc;
+		}
+
+		static void parse(JsonReader& r, char8_t* json, size_t len, yyjson_read_flag flags) {
+			r.document = reinterpret_cast<JsonReaderDocument*>(parse_document(r, document_allocator(r), json, len, flags));
+		}
+
+		// line and column cost one more pass up to the error, everything else only looks at the bytes around it
+		static void fail(JsonReader& r, const char8_t* json, size_t len, const yyjson_read_err& err) {
+			if (!r.failure) {
+				r.failure = new JsonParseError;
+			}
+
+			auto& e = *r.failure;
+			e.offset = std::min(err.pos, len);
+			e.message = err.msg;
+			size_t chr;
+			if (!yyjson_locate_pos(reinterpret_cast<const char*>(json), len, e.offset, &e.line, &e.column, &chr)) {
+				e.line = e.column = 0;
+			}
+
+			constexpr size_t half = JsonParseError::excerpt_capacity / 2;
+			size_t begin = e.offset > half ? e.offset - half : 0;
+			size_t end = std::min(len, e.offset + half);
+			while (begin < e.offset && (json[begin] & 0xC0) == 0x80) {
+				begin++;
+			}
+			while (end > e.offset && end < len && (json[end] & 0xC0) == 0x80) {
+				end--;
+			}
+			std::memcpy(e.excerpt, json + begin, end - begin);
+			e.excerpt_length = end - begin;
+			e.excerpt_offset = e.offset - begin;
+
+			if (log_parse_errors.load(std::memory_order_relaxed)) {
+				LOG_ERROR(u8"Failed to parse JSON at line {}, column {}: {}, near: {}", e.line, e.column, e.message, e.context());
+			}
+		}
+
+		static void parse(JsonReader& r, const char8_t* json, size_t len) {
+			// the input is copied by yyjson without YYJSON_READ_INSITU
+			parse(r, const_cast<char8_t*>(json), len, 0);
+		}
+
+		static void parse(JsonReader& r, std::span<char8_t> buffer, size_t len) {
+			static_assert(JsonReader::insitu_padding == YYJSON_PADDING_SIZE);
+
+			if (buffer.size() < len + YYJSON_PADDING_SIZE) {
+				parse(r, buffer.data(), len);
+				return;
+			}
+
+			std::memset(buffer.data() + len, 0, YYJSON_PADDING_SIZE);
+			parse(r, buffer.data(), len, YYJSON_READ_INSITU);
+		}
+
+		static std::expected<JsonReader, JsonErrorCode> load(JsonReader r, const char8_t* path) {
+			auto mapped = MapFile(path);
+			if (!mapped) {
+				return std::unexpected(JsonErrorCode::FileIOFailed);
+			}
+
+			// in situ parsing would write to every page and turn the whole file into private copies,
+			// yyjson copies the input into the document instead and the mapping goes right away
+			parse(r, static_cast<const char8_t*>(mapped->data), mapped->size);
+			UnmapFile(mapped);
+
+			if (!r.document) {
+				return std::unexpected(JsonErrorCode::ParseFailed);
+			}
+			return r;
 		}
 
 		template<typename T>
@@ -129,9 +1929,11 @@ namespace auxiliary
 				return std::unexpected(NoOpenScope);
 			}
 
+			if (r.lazy) {
+				return lazy_read(r, key, value);
+			}
+
 			auto type = r.stack.top().type;
-			auto parent = r.stack.top().value;
-			const char* ckey = reinterpret_cast<const char*>(key.data());
 			yyjson_val* found = nullptr;
 
 			if (type == kObject) {
@@ -139,7 +1941,7 @@ namespace auxiliary
 					return std::unexpected(EmptyObjectFieldKey);
 				}
 
-				found = yyjson_obj_get(parent, ckey);
+				found = find_member(r, r.stack.top(), key);
 				if (!found) {
 					return std::unexpected(KeyNotFound);
 				}
@@ -148,79 +1950,381 @@ namespace auxiliary
 					return std::unexpected(ArrayElementWithKey);
 				}
 
-				found = yyjson_arr_get(parent, r.stack.top().index++);
+				found = next_element(r.stack.top());
 				if (!found) {
 					return std::unexpected(KeyNotFound);
 				}
 			}
 
+			return get_value(found, value);
+		}
+
+		template<typename T>
+		static std::expected<void, JsonErrorCode> get_value(yyjson_val* found, T& value) noexcept {
 			if constexpr (std::is_same_v<T, bool>) {
 				value = yyjson_get_bool(found);
-			} else if constexpr (std::is_same_v<T, int64_t>) {
-				value = yyjson_get_sint(found);
-			} else if constexpr (std::is_same_v<T, uint64_t>) {
-				value = yyjson_get_uint(found);
-			} else if constexpr (std::is_same_v<T, double>) {
-				value = yyjson_get_real(found);
+			} else if constexpr (std::is_same_v<T, int64_t> || std::is_same_v<T, uint64_t> || std::is_same_v<T, double>) {
+				return take_number(element_number(found), value);
+			} else if constexpr (std::is_same_v<T, JsonRawNumber>) {
+				if (!yyjson_is_raw(found)) {
+					// without RawNumbers the text of a number is gone after parsing
+					return std::unexpected(yyjson_is_num(found) ? JsonErrorCode::UnknownTypeToRead : JsonErrorCode::ElementTypeMismatch);
+				}
+				value = {reinterpret_cast<const char8_t*>(yyjson_get_raw(found)), yyjson_get_len(found)};
+			} else if constexpr (std::is_same_v<T, u8string_view>) {
+				value = yyjson_is_str(found) ? u8string_view{reinterpret_cast<const char8_t*>(yyjson_get_str(found)), yyjson_get_len(found)} : u8string_view{};
 			} else {
 				value = yyjson_get_str(found);
 			}
 			return {};
 		}
+
+		// integers that don't fit T are out of range, doubles take integers like store_number does, reals read into integers as 0
+		template<typename T>
+		static std::expected<void, JsonErrorCode> take_number(const JsonScanNumber& number, T& value) noexcept {
+			using enum JsonScanNumber::EType;
+
+			if constexpr (std::is_same_v<T, double>) {
+				switch (number.type) {
+					case kReal: value = number.real;
+						break;
+					case kSint: value = static_cast<double>(number.sint);
+						break;
+					case kUint: value = static_cast<double>(number.uint);
+						break;
+					default: value = 0.0;
+				}
+			} else if (number.type == kSint) {
+				if (!std::in_range<T>(number.sint)) {
+					return std::unexpected(JsonErrorCode::NumberOutOfRange);
+				}
+				value = static_cast<T>(number.sint);
+			} else if (number.type == kUint) {
+				if (!std::in_range<T>(number.uint)) {
+					return std::unexpected(JsonErrorCode::NumberOutOfRange);
+				}
+				value = static_cast<T>(number.uint);
+			} else {
+				value = 0;
+			}
+			return {};
+		}
+
+		// the object of a JsonFields type is on top of the stack, so only the member is looked up
+		template<typename T>
+		static std::expected<void, JsonErrorCode> read_field(JsonReader& r, const JsonStaticKey& key, T& value) {
+			const JsonStaticKey* previous = std::exchange(r.static_key, &key);
+			yyjson_val* found = nullptr;
+			std::expected<void, JsonErrorCode> result;
+			if (r.lazy) {
+				result = lazy_read(r, key.view(), value);
+			} else if ((found = find_member(r, r.stack.top(), key.view()))) {
+				result = get_value(found, value);
+			} else {
+				result = std::unexpected(JsonErrorCode::KeyNotFound);
+			}
+			r.static_key = previous;
+			return result;
+		}
+
+		static JsonScanNumber element_number(yyjson_val* val) noexcept {
+			// RawNumbers mode converts on access
+			if (yyjson_is_raw(val)) {
+				const size_t length = yyjson_get_len(val);
+				return JsonScanner{reinterpret_cast<const char8_t*>(yyjson_get_raw(val)), length}.read_number(0, length);
+			}
+
+			JsonScanNumber number;
+			if (yyjson_is_real(val)) {
+				number.type = JsonScanNumber::kReal;
+				number.real = yyjson_get_real(val);
+			} else if (yyjson_is_uint(val)) {
+				number.type = JsonScanNumber::kUint;
+				number.uint = yyjson_get_uint(val);
+			} else if (yyjson_is_sint(val)) {
+				number.type = JsonScanNumber::kSint;
+				number.sint = yyjson_get_sint(val);
+			}
+			return number;
+		}
+
+		// false if number does not fit T, integers are never taken from reals
+		template<typename T>
+		static bool store_number(const JsonScanNumber& number, T& value) noexcept {
+			using enum JsonScanNumber::EType;
+
+			if constexpr (std::is_floating_point_v<T>) {
+				double real;
+				switch (number.type) {
+					case kReal: real = number.real;
+						break;
+					case kSint: real = static_cast<double>(number.sint);
+						break;
+					case kUint: real = static_cast<double>(number.uint);
+						break;
+					default:
+						return false;
+				}
+				if (std::is_same_v<T, float> && std::abs(real) > std::numeric_limits<float>::max()) {
+					return false;
+				}
+				value = static_cast<T>(real);
+			} else if (number.type == kSint && std::in_range<T>(number.sint)) {
+				value = static_cast<T>(number.sint);
+			} else if (number.type == kUint && std::in_range<T>(number.uint)) {
+				value = static_cast<T>(number.uint);
+			} else {
+				return false;
+			}
+			return true;
+		}
+
+		template<typename T>
+		static std::expected<void, JsonErrorCode> read_array(JsonReader& r, size_t count, T* values, size_t* mismatch) {
+			using enum JsonErrorCode;
+
+			if (r.stack.empty()) {
+				return std::unexpected(NoOpenScope);
+			}
+
+			auto& level = r.stack.top();
+			if (level.type != JsonReader::Level::kArray) {
+				return std::unexpected(ScopeTypeMismatch);
+			}
+
+			auto reject = [mismatch](size_t index) {
+				if (mismatch) {
+					*mismatch = index;
+				}
+				return std::unexpected(ElementTypeMismatch);
+			};
+
+			// every element is checked before the first one is stored, so a failed read leaves values and the position alone
+			if (r.lazy) {
+				auto& d = *r.lazy;
+				const auto& scanner = d.scanner;
+				auto start = lazy_cursor(d, d.stack.back());
+				if (!start.has_value()) {
+					return std::unexpected(start.error());
+				}
+
+				size_t pos = start.value();
+				for (size_t i = 0; i < count; i++) {
+					if (scanner.at(pos) == u8']') {
+						return std::unexpected(KeyNotFound);
+					}
+					const size_t end = scanner.skip_value(pos);
+					if (end == JsonScanner::npos) {
+						return std::unexpected(ParseFailed);
+					}
+					if (T value; !store_token(scanner, pos, end, value)) {
+						return reject(i);
+					}
+					pos = scanner.next_member(end);
+					if (pos == JsonScanner::npos) {
+						return std::unexpected(ParseFailed);
+					}
+				}
+
+				pos = start.value();
+				for (size_t i = 0; i < count; i++) {
+					const size_t end = scanner.skip_value(pos);
+					store_token(scanner, pos, end, values[i]);
+					pos = scanner.next_member(end);
+				}
+				d.stack.back().cursor = pos;
+				return {};
+			}
+
+			const size_t size = yyjson_arr_size(level.value);
+			if (count == 0) {
+				return {};
+			}
+			if (level.index >= size || count > size - level.index) {
+				return std::unexpected(KeyNotFound);
+			}
+
+			// scalar elements sit next to each other, so both passes are linear walks over the document
+			yyjson_val* const first = level.index == 0 ? yyjson_arr_get_first(level.value) : unsafe_yyjson_get_next(level.cursor);
+			yyjson_val* element = first;
+			for (size_t i = 0; i < count; i++, element = unsafe_yyjson_get_next(element)) {
+				if (T value; !store_element(element, value)) {
+					return reject(i);
+				}
+			}
+
+			element = first;
+			for (size_t i = 0;; i++) {
+				store_element(element, values[i]);
+				if (i + 1 == count) {
+					break;
+				}
+				element = unsafe_yyjson_get_next(element);
+			}
+			level.index += static_cast<uint32_t>(count);
+			level.cursor = reinterpret_cast<JsonReaderValue*>(element);
+			return {};
+		}
+
+		template<typename T>
+		static bool store_element(yyjson_val* element, T& value) noexcept {
+			if constexpr (std::is_same_v<T, bool>) {
+				if (!yyjson_is_bool(element)) {
+					return false;
+				}
+				value = yyjson_get_bool(element);
+				return true;
+			} else {
+				return store_number(element_number(element), value);
+			}
+		}
+
+		template<typename T>
+		static bool store_token(const JsonScanner& scanner, size_t begin, size_t end, T& value) noexcept {
+			if constexpr (std::is_same_v<T, bool>) {
+				const u8string_view token{scanner.data() + begin, end - begin};
+				if (token != u8"true" && token != u8"false") {
+					return false;
+				}
+				value = token.size() == 4;
+				return true;
+			} else {
+				return store_number(scanner.read_number(begin, end), value);
+			}
+		}
 	};
 }
 
-namespace auxiliary
-{
-	JsonWriter::JsonWriter(size_t level_depth) {
-		document = reinterpret_cast<JsonWriterDocument*>(yyjson_mut_doc_new(nullptr));
+namespace auxiliary
+{
+	void* JsonAllocator::reallocate(void* ptr, size_t old_size, size_t size) {
+		void* result = allocate(size);
+		if (result && ptr) {
+			std::memcpy(result, ptr, old_size < size ? old_size : size);
+			deallocate(ptr);
+		}
+		return result;
+	}
+
+	JsonMonotonicAllocator::JsonMonotonicAllocator() : arena(new JsonArena) {}
+
+	JsonMonotonicAllocator::JsonMonotonicAllocator(std::span<std::byte> buffer, bool upstream) : arena(new JsonArena(buffer, upstream)) {}
+
+	JsonMonotonicAllocator::~JsonMonotonicAllocator() {
+		delete arena;
+	}
+
+	void* JsonMonotonicAllocator::allocate(size_t size) {
+		return arena->allocate(size);
+	}
+
+	void* JsonMonotonicAllocator::reallocate(void* ptr, size_t old_size, size_t size) {
+		return arena->reallocate(ptr, old_size, size);
+	}
+
+	void JsonMonotonicAllocator::release() noexcept {
+		arena->release();
+	}
+}
+
+namespace auxiliary
+{
+	JsonWriter::JsonWriter(size_t level_depth): JsonWriter(level_depth, JsonWriteMode::Document) {}
+
+	JsonWriter::JsonWriter(size_t level_depth, JsonWriteMode mode) {
+		if (mode == JsonWriteMode::Stream) {
+			stream = new JsonWriterStream;
+		} else {
+			arena = new JsonArena;
+			auto alc = arena->allocator();
+			document = reinterpret_cast<JsonWriterDocument*>(yyjson_mut_doc_new(&alc));
+		}
+		stack.reserve(level_depth);
+	}
+
+	JsonWriter::JsonWriter(size_t level_depth, JsonSink& sink, size_t chunk_size): JsonWriter(level_depth, JsonWriteMode::Stream) {
+		stream->sink = &sink;
+		stream->chunk_size = chunk_size;
+	}
+
+	JsonWriter::JsonWriter(size_t level_depth, JsonAllocator& allocator): allocator(&allocator) {
+		auto alc = AllocatorBridge(allocator);
+		document = reinterpret_cast<JsonWriterDocument*>(yyjson_mut_doc_new(&alc));
 		stack.reserve(level_depth);
 	}
 
 	JsonWriter::~JsonWriter() {
 		yyjson_mut_doc_free(document);
+		delete adopted;
+		delete arena;
+		delete stream;
+		delete scratch;
+	}
+
+	void JsonWriter::reset() {
+		stack.clear();
+
+		if (stream) {
+			stream->buffer.clear();
+			stream->has_root = false;
+			stream->failed = false;
+			return;
+		}
+
+		yyjson_mut_doc_free(document);
+		if (adopted) {
+			adopted->release();
+		}
+		if (arena) {
+			arena->rewind();
+		}
+		auto alc = JsonImpl::document_allocator(*this);
+		document = reinterpret_cast<JsonWriterDocument*>(yyjson_mut_doc_new(&alc));
 	}
 
 	std::expected<void, JsonErrorCode> JsonWriter::start_object(u8string_view key) {
 		using enum JsonErrorCode;
 
-		yyjson_mut_val* obj = yyjson_mut_obj(document);
+		if (stream) {
+			if (stack.empty()) {
+				if (!key.empty()) {
+					return std::unexpected(RootObjectWithKey);
+				}
+				// further roots make newline delimited output
+				if (stream->has_root) {
+					stream->buffer.append(u8'\n');
+				}
+				stream->has_root = true;
+			} else if (auto result = JsonImpl::stream_prefix(*this, key); !result.has_value()) {
+				return result;
+			}
+
+			stream->buffer.append(u8'{');
+			stack.emplace(nullptr, Level::kObject);
+			return stream->commit();
+		}
 
 		if (stack.empty()) {
 			if (!key.empty()) {
 				return std::unexpected(RootObjectWithKey);
 			}
 
+			yyjson_mut_val* obj = yyjson_mut_obj(document);
 			yyjson_mut_doc_set_root(document, obj);
-			stack.emplace_back(reinterpret_cast<JsonWriterValue*>(obj), Level::kObject);
+			stack.emplace(reinterpret_cast<JsonWriterValue*>(obj), Level::kObject);
 			return {};
 		}
 
-		const auto level = stack.back();
-
-		if (level.type == Level::kArray) {
-			if (!key.empty()) {
-				return std::unexpected(ArrayElementWithKey);
-			}
-
-			bool success = yyjson_mut_arr_add_val(level.value, obj);
-			if (success) {
-				stack.emplace_back(reinterpret_cast<JsonWriterValue*>(obj), Level::kObject);
-				return {};
-			}
-		} else if (level.type == Level::kObject) {
-			if (key.empty()) {
-				return std::unexpected(EmptyObjectFieldKey);
-			}
-
-			const char* ckey = CStringBuild(document, key);
-			bool success = yyjson_mut_obj_add_val(document, level.value, ckey, obj);
-			if (success) {
-				stack.emplace_back(reinterpret_cast<JsonWriterValue*>(obj), Level::kObject);
-				return {};
-			}
+		const auto level = stack.top();
+		if (auto result = JsonImpl::check_key(level, key); !result.has_value()) {
+			return result;
 		}
 
+		yyjson_mut_val* obj = yyjson_mut_obj(document);
+		if (JsonImpl::attach(*this, level, key, obj)) {
+			stack.emplace(reinterpret_cast<JsonWriterValue*>(obj), Level::kObject);
+			return {};
+		}
 		return std::unexpected(UnknownError);
 	}
 
@@ -231,25 +2335,26 @@ namespace auxiliary
 			return std::unexpected(NoOpenScope);
 		}
 
-		yyjson_mut_val* arr = yyjson_mut_arr(document);
-		auto [array,type] = stack.back();
-		bool success = false;
-
-		if (type == Level::kArray) {
-			if (!key.empty()) {
-				return std::unexpected(ArrayElementWithKey);
-			}
-			success = yyjson_mut_arr_add_val(array, arr);
-		} else if (type == Level::kObject) {
-			if (key.empty()) {
-				return std::unexpected(EmptyObjectFieldKey);
+		if (stream) {
+			if (auto result = JsonImpl::stream_prefix(*this, key); !result.has_value()) {
+				return result;
 			}
-			const char* ckey = CStringBuild(document, key);
-			success = yyjson_mut_obj_add_val(document, array, ckey, arr);
+
+			stream->buffer.append(u8'[');
+			stack.emplace(nullptr, Level::kArray);
+			return stream->commit();
+		}
+
+		const auto level = stack.top();
+		if (auto result = JsonImpl::check_key(level, key); !result.has_value()) {
+			return result;
 		}
 
-		stack.emplace_back(reinterpret_cast<JsonWriterValue*>(arr), Level::kArray);
-		if (success) return {};
+		yyjson_mut_val* arr = yyjson_mut_arr(document);
+		if (JsonImpl::attach(*this, level, key, arr)) {
+			stack.emplace(reinterpret_cast<JsonWriterValue*>(arr), Level::kArray);
+			return {};
+		}
 		return std::unexpected(UnknownError);
 	}
 
@@ -258,10 +2363,14 @@ namespace auxiliary
 		if (stack.empty()) {
 			return std::unexpected(NoOpenScope);
 		}
-		if (stack.back().type != Level::kArray) {
+		if (stack.top().type != Level::kArray) {
 			return std::unexpected(ScopeTypeMismatch);
 		}
-		stack.pop_back();
+
+		if (stream) {
+			return stream->close(u8']', stack);
+		}
+		stack.pop();
 		return {};
 	}
 
@@ -270,20 +2379,89 @@ namespace auxiliary
 		if (stack.empty()) {
 			return std::unexpected(NoOpenScope);
 		}
-		if (stack.back().type != Level::kObject) {
+		if (stack.top().type != Level::kObject) {
 			return std::unexpected(ScopeTypeMismatch);
 		}
-		stack.pop_back();
+
+		if (stream) {
+			return stream->close(u8'}', stack);
+		}
+		stack.pop();
+		return {};
+	}
+
+	std::expected<void, JsonErrorCode> JsonWriter::flush() {
+		if (stream) {
+			return stream->flush();
+		}
 		return {};
 	}
 
 	u8string JsonWriter::dump() const {
-		auto str = yyjson_mut_write(document, 0, nullptr);
-		u8string ret = str;
-		free(str);
+		u8string ret;
+		if (auto result = dump_to(ret); !result.has_value()) {
+			LOG_ERROR(u8"Failed to dump JSON, error {}", std::to_underlying(result.error()));
+			assert(!"JsonWriter::dump() failed, dump_to() reports the error");
+			ret.clear();
+		}
 		return ret;
 	}
 
+	std::expected<void, JsonErrorCode> JsonWriter::splice(u8string_view key, JsonWriter& child) {
+		return JsonImpl::splice(*this, key, child);
+	}
+
+	std::expected<void, JsonErrorCode> JsonWriter::edit(const JsonReader& reader) {
+		return JsonImpl::edit(*this, reader);
+	}
+
+	std::expected<void, JsonErrorCode> JsonWriter::remove(const JsonPath& path) {
+		return JsonImpl::patch(*this, path, EPatch::kRemove, JsonPathValue{}, false);
+	}
+
+	std::expected<void, JsonErrorCode> JsonWriter::patch(const JsonPath& path, EPatch mode, const JsonPathValue& value, bool raw) {
+		return JsonImpl::patch(*this, path, mode, value, raw);
+	}
+
+	std::expected<size_t, JsonErrorCode> JsonWriter::dump_to(u8string& out) const {
+		return JsonImpl::serialize(*this, [&](u8string_view text) -> std::expected<size_t, JsonErrorCode> {
+			// assigning keeps the capacity of out, the length comes from the writer instead of strlen
+			out.assign(text.data(), text.size());
+			return text.size();
+		});
+	}
+
+	std::expected<size_t, JsonErrorCode> JsonWriter::dump_to(std::span<char8_t> out) const {
+		return JsonImpl::serialize(*this, [&](u8string_view text) -> std::expected<size_t, JsonErrorCode> {
+			if (text.size() > out.size()) {
+				return std::unexpected(JsonErrorCode::BufferTooSmall);
+			}
+			std::memcpy(out.data(), text.data(), text.size());
+			return text.size();
+		});
+	}
+
+	std::expected<void, JsonErrorCode> JsonWriter::dump_to_file(const char8_t* path) const {
+		FILE* file = OpenFile(path, "wb");
+		if (!file) {
+			return std::unexpected(JsonErrorCode::FileIOFailed);
+		}
+
+		bool success = false;
+		if (stream) {
+			success = std::fwrite(stream->buffer.data(), 1, stream->buffer.size(), file) == stream->buffer.size();
+		} else {
+			auto alc = JsonImpl::output_allocator(*this);
+			success = yyjson_mut_write_fp(file, document, 0, &alc, nullptr);
+		}
+
+		success = (std::fclose(file) == 0) && success;
+		if (success) {
+			return {};
+		}
+		return std::unexpected(JsonErrorCode::FileIOFailed);
+	}
+
 	std::expected<void, JsonErrorCode>
 	JsonWriter::write(u8string_view key, bool value) {
 		return JsonImpl::write(*this, key, value);
@@ -309,18 +2487,71 @@ namespace auxiliary
 		return JsonImpl::write(*this, key, reinterpret_cast<const char*>(value), len);
 	}
 
+	std::expected<void, JsonErrorCode>
+	JsonWriter::write(u8string_view key, const JsonRawNumber& value) {
+		return JsonImpl::write(*this, key, value);
+	}
+
+	std::expected<void, JsonErrorCode> JsonWriter::write_field(JsonStaticKey key, bool value) {
+		return JsonImpl::write_field(*this, key, value);
+	}
+
+	std::expected<void, JsonErrorCode> JsonWriter::write_field(JsonStaticKey key, int64_t value) {
+		return JsonImpl::write_field(*this, key, value);
+	}
+
+	std::expected<void, JsonErrorCode> JsonWriter::write_field(JsonStaticKey key, uint64_t value) {
+		return JsonImpl::write_field(*this, key, value);
+	}
+
+	std::expected<void, JsonErrorCode> JsonWriter::write_field(JsonStaticKey key, double value) {
+		return JsonImpl::write_field(*this, key, value);
+	}
+
+	std::expected<void, JsonErrorCode> JsonWriter::write_field(JsonStaticKey key, const char8_t* value, size_t len) {
+		return JsonImpl::write_field(*this, key, reinterpret_cast<const char*>(value), len);
+	}
+
 	std::expected<void, JsonErrorCode> JsonWriter::write(size_t count, u8string_view key, const bool* value) {
 		return JsonImpl::write_array(*this, count, key, value);
 	}
 
+	std::expected<void, JsonErrorCode> JsonWriter::write(size_t count, u8string_view key, const int8_t* value) {
+		return JsonImpl::write_array(*this, count, key, value);
+	}
+
+	std::expected<void, JsonErrorCode> JsonWriter::write(size_t count, u8string_view key, const int16_t* value) {
+		return JsonImpl::write_array(*this, count, key, value);
+	}
+
+	std::expected<void, JsonErrorCode> JsonWriter::write(size_t count, u8string_view key, const int32_t* value) {
+		return JsonImpl::write_array(*this, count, key, value);
+	}
+
 	std::expected<void, JsonErrorCode> JsonWriter::write(size_t count, u8string_view key, const int64_t* value) {
 		return JsonImpl::write_array(*this, count, key, value);
 	}
 
+	std::expected<void, JsonErrorCode> JsonWriter::write(size_t count, u8string_view key, const uint8_t* value) {
+		return JsonImpl::write_array(*this, count, key, value);
+	}
+
+	std::expected<void, JsonErrorCode> JsonWriter::write(size_t count, u8string_view key, const uint16_t* value) {
+		return JsonImpl::write_array(*this, count, key, value);
+	}
+
+	std::expected<void, JsonErrorCode> JsonWriter::write(size_t count, u8string_view key, const uint32_t* value) {
+		return JsonImpl::write_array(*this, count, key, value);
+	}
+
 	std::expected<void, JsonErrorCode> JsonWriter::write(size_t count, u8string_view key, const uint64_t* value) {
 		return JsonImpl::write_array(*this, count, key, value);
 	}
 
+	std::expected<void, JsonErrorCode> JsonWriter::write(size_t count, u8string_view key, const float* value) {
+		return JsonImpl::write_array(*this, count, key, value);
+	}
+
 	std::expected<void, JsonErrorCode> JsonWriter::write(size_t count, u8string_view key, const double* value) {
 		return JsonImpl::write_array(*this, count, key, value);
 	}
@@ -335,20 +2566,127 @@ namespace auxiliary
 namespace auxiliary
 {
 	JsonReader::JsonReader(const char8_t* json, size_t len) {
-		yyjson_read_err err = {};
-		document = reinterpret_cast<JsonReaderDocument*>(yyjson_read_opts(reinterpret_cast<char*>(const_cast<char8_t*>(json)), len, 0, nullptr, &err));
-		if (document == nullptr) {
-			LOG_ERROR(u8"Failed to parse JSON: {}, error: {}", u8string_view{json, len}, err.msg);
+		arena = new JsonArena;
+		JsonImpl::parse(*this, json, len);
+	}
+
+	JsonReader::JsonReader(const char8_t* json, size_t len, JsonAllocator& allocator): allocator(&allocator) {
+		JsonImpl::parse(*this, json, len);
+	}
+
+	JsonReader::JsonReader(std::span<char8_t> buffer, size_t len) {
+		arena = new JsonArena;
+		JsonImpl::parse(*this, buffer, len);
+	}
+
+	JsonReader::JsonReader(std::span<char8_t> buffer, size_t len, JsonAllocator& allocator): allocator(&allocator) {
+		JsonImpl::parse(*this, buffer, len);
+	}
+
+	const JsonParseError* JsonReader::parse_error() const noexcept {
+		return failure && failure->offset != JsonParseError::no_error ? failure : nullptr;
+	}
+
+	void JsonReader::set_error_logging(bool enabled) noexcept {
+		JsonImpl::log_parse_errors.store(enabled, std::memory_order_relaxed);
+	}
+
+	JsonStats JsonReader::validate(u8string_view json) noexcept {
+		return JsonValidator::validate(json.data(), json.size());
+	}
+
+	JsonReader::JsonReader(JsonReadMode mode) : raw_numbers(mode == JsonReadMode::RawNumbers) {
+		if (mode == JsonReadMode::OnDemand) {
+			lazy = new JsonLazyDocument;
+		} else {
+			arena = new JsonArena;
+		}
+	}
+
+	JsonReader::JsonReader(u8string_view json, JsonReadMode mode) : JsonReader(mode) {
+		reset(json);
+	}
+
+	JsonReader::JsonReader(JsonReader&& other) noexcept
+		: document(std::exchange(other.document, nullptr)),
+		  arena(std::exchange(other.arena, nullptr)),
+		  allocator(std::exchange(other.allocator, nullptr)),
+		  lazy(std::exchange(other.lazy, nullptr)),
+		  key_index(std::exchange(other.key_index, nullptr)),
+		  key_index_threshold(other.key_index_threshold),
+		  failure(std::exchange(other.failure, nullptr)),
+		  raw_numbers(other.raw_numbers),
+		  stack(std::move(other.stack)) {}
+
+	JsonReader& JsonReader::operator=(JsonReader&& other) noexcept {
+		if (this != &other) {
+			yyjson_doc_free(document);
+			delete lazy;
+			delete key_index;
+			delete failure;
+			delete arena;
+
+			document = std::exchange(other.document, nullptr);
+			arena = std::exchange(other.arena, nullptr);
+			allocator = std::exchange(other.allocator, nullptr);
+			lazy = std::exchange(other.lazy, nullptr);
+			key_index = std::exchange(other.key_index, nullptr);
+			key_index_threshold = other.key_index_threshold;
+			failure = std::exchange(other.failure, nullptr);
+			raw_numbers = other.raw_numbers;
+			stack = std::move(other.stack);
 		}
+		return *this;
 	}
 
 	JsonReader::~JsonReader() {
 		yyjson_doc_free(document);
+		delete lazy;
+		delete key_index;
+		delete failure;
+		delete arena;
+	}
+
+	std::expected<JsonReader, JsonErrorCode> JsonReader::from_file(const char8_t* path) {
+		JsonReader reader;
+		reader.arena = new JsonArena;
+		return JsonImpl::load(std::move(reader), path);
+	}
+
+	std::expected<JsonReader, JsonErrorCode> JsonReader::from_file(const char8_t* path, JsonAllocator& allocator) {
+		JsonReader reader;
+		reader.allocator = &allocator;
+		return JsonImpl::load(std::move(reader), path);
+	}
+
+	void JsonReader::reset(u8string_view new_input) {
+		JsonImpl::clear(*this);
+		if (lazy) {
+			lazy->scanner = JsonScanner{new_input.data(), new_input.size()};
+			return;
+		}
+		JsonImpl::parse(*this, new_input.data(), new_input.size());
+	}
+
+	void JsonReader::reset(std::span<char8_t> buffer, size_t len) {
+		JsonImpl::clear(*this);
+		if (lazy) {
+			lazy->scanner = JsonScanner{buffer.data(), len};
+			return;
+		}
+		JsonImpl::parse(*this, buffer, len);
 	}
 
 	std::expected<void, JsonErrorCode> JsonReader::start_object(u8string_view key) {
 		using enum JsonErrorCode;
 
+		if (lazy) {
+			if (auto result = JsonImpl::lazy_start(*this, key, Level::kObject); !result.has_value()) {
+				return std::unexpected(result.error());
+			}
+			return {};
+		}
+
 		if (stack.empty()) {
 			if (!key.empty()) {
 				return std::unexpected(RootObjectWithKey);
@@ -371,7 +2709,7 @@ namespace auxiliary
 				return std::unexpected(ArrayElementWithKey);
 			}
 
-			auto obj = yyjson_arr_get(parent, stack.top().index++);
+			auto obj = JsonImpl::next_element(stack.top());
 			if (!obj) {
 				return std::unexpected(KeyNotFound);
 			}
@@ -389,7 +2727,7 @@ namespace auxiliary
 				return std::unexpected(EmptyObjectFieldKey);
 			}
 
-			auto obj = yyjson_obj_get(parent, reinterpret_cast<const char*>(key.data()));
+			auto obj = JsonImpl::find_member(*this, stack.top(), key);
 			if (!obj) {
 				return std::unexpected(KeyNotFound);
 			}
@@ -408,6 +2746,10 @@ namespace auxiliary
 	std::expected<size_t, JsonErrorCode> JsonReader::start_array(u8string_view key) {
 		using enum JsonErrorCode;
 
+		if (lazy) {
+			return JsonImpl::lazy_start(*this, key, Level::kArray);
+		}
+
 		if (stack.empty()) {
 			return std::unexpected(NoOpenScope);
 		}
@@ -420,7 +2762,7 @@ namespace auxiliary
 				return std::unexpected(ArrayElementWithKey);
 			}
 
-			auto arr = yyjson_arr_get(parent, stack.top().index++);
+			auto arr = JsonImpl::next_element(stack.top());
 			if (!arr) {
 				return std::unexpected(KeyNotFound);
 			}
@@ -437,7 +2779,7 @@ namespace auxiliary
 			if (key.empty()) {
 				return std::unexpected(EmptyObjectFieldKey);
 			}
-			auto arr = yyjson_obj_get(parent, reinterpret_cast<const char*>(key.data()));
+			auto arr = JsonImpl::find_member(*this, stack.top(), key);
 			if (!arr) {
 				return std::unexpected(KeyNotFound);
 			}
@@ -461,6 +2803,9 @@ namespace auxiliary
 		if (stack.top().type != Level::kArray) {
 			return std::unexpected(ScopeTypeMismatch);
 		}
+		if (lazy) {
+			JsonImpl::lazy_end(*this);
+		}
 		stack.pop();
 		return {};
 	}
@@ -473,6 +2818,9 @@ namespace auxiliary
 		if (stack.top().type != Level::kObject) {
 			return std::unexpected(ScopeTypeMismatch);
 		}
+		if (lazy) {
+			JsonImpl::lazy_end(*this);
+		}
 		stack.pop();
 		return {};
 	}
@@ -496,4 +2844,259 @@ namespace auxiliary
 	std::expected<void, JsonErrorCode> JsonReader::read(u8string_view key, const char8_t*& value) {
 		return JsonImpl::read(*this, key, reinterpret_cast<const char*&>(value));
 	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read(u8string_view key, u8string_view& value) {
+		return JsonImpl::read(*this, key, value);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read(u8string_view key, JsonRawNumber& value) {
+		return JsonImpl::read(*this, key, value);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read_field(JsonStaticKey key, bool& value) {
+		return JsonImpl::read_field(*this, key, value);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read_field(JsonStaticKey key, int64_t& value) {
+		return JsonImpl::read_field(*this, key, value);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read_field(JsonStaticKey key, uint64_t& value) {
+		return JsonImpl::read_field(*this, key, value);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read_field(JsonStaticKey key, double& value) {
+		return JsonImpl::read_field(*this, key, value);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read_field(JsonStaticKey key, const char8_t*& value) {
+		return JsonImpl::read_field(*this, key, reinterpret_cast<const char*&>(value));
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read_field(JsonStaticKey key, u8string_view& value) {
+		return JsonImpl::read_field(*this, key, value);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read(size_t count, bool* values, size_t* mismatch) {
+		return JsonImpl::read_array(*this, count, values, mismatch);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read(size_t count, int8_t* values, size_t* mismatch) {
+		return JsonImpl::read_array(*this, count, values, mismatch);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read(size_t count, int16_t* values, size_t* mismatch) {
+		return JsonImpl::read_array(*this, count, values, mismatch);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read(size_t count, int32_t* values, size_t* mismatch) {
+		return JsonImpl::read_array(*this, count, values, mismatch);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read(size_t count, int64_t* values, size_t* mismatch) {
+		return JsonImpl::read_array(*this, count, values, mismatch);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read(size_t count, uint8_t* values, size_t* mismatch) {
+		return JsonImpl::read_array(*this, count, values, mismatch);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read(size_t count, uint16_t* values, size_t* mismatch) {
+		return JsonImpl::read_array(*this, count, values, mismatch);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read(size_t count, uint32_t* values, size_t* mismatch) {
+		return JsonImpl::read_array(*this, count, values, mismatch);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read(size_t count, uint64_t* values, size_t* mismatch) {
+		return JsonImpl::read_array(*this, count, values, mismatch);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read(size_t count, float* values, size_t* mismatch) {
+		return JsonImpl::read_array(*this, count, values, mismatch);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::read(size_t count, double* values, size_t* mismatch) {
+		return JsonImpl::read_array(*this, count, values, mismatch);
+	}
+
+	std::expected<JsonPathValue, JsonErrorCode> JsonReader::resolve(const JsonPath& path) {
+		return JsonImpl::resolve(*this, path);
+	}
+
+	std::expected<void, JsonErrorCode> JsonReader::resolve(std::span<const JsonPath> paths, std::span<JsonPathValue> values) {
+		return JsonImpl::resolve(*this, paths, values);
+	}
+
+	std::expected<JsonPath, JsonErrorCode> JsonPath::compile(u8string_view path) {
+		JsonPath result;
+		const char8_t* p = path.data();
+		const char8_t* end = p + path.size();
+		if (p == end) {
+			return result;
+		}
+
+		const bool pointer = *p == u8'/';
+		if (pointer) {
+			p++;
+		}
+
+		while (true) {
+			Step step{result.keys.size(), 0, 0, SIZE_MAX};
+			for (; p != end && *p != (pointer ? u8'/' : u8'.'); p++) {
+				char8_t c = *p;
+				if (pointer && c == u8'~') {
+					if (++p == end || (*p != u8'0' && *p != u8'1')) {
+						return std::unexpected(JsonErrorCode::InvalidPath);
+					}
+					c = *p == u8'0' ? u8'~' : u8'/';
+				}
+				result.keys.push_back(c);
+			}
+			step.length = result.keys.size() - step.offset;
+			if (!pointer && step.length == 0) {
+				return std::unexpected(JsonErrorCode::InvalidPath);
+			}
+
+			const u8string_view key{result.keys.data() + step.offset, step.length};
+			step.hash = Hash<u8string_view>()(key);
+			const char8_t* digits = result.keys.data() + step.offset;
+			if (step.length != 0 && (digits[0] != u8'0' || step.length == 1)) {
+				size_t index = 0;
+				for (size_t i = 0; i < step.length; i++) {
+					const char8_t c = digits[i];
+					if (c < u8'0' || c > u8'9' || index > (SIZE_MAX - 9) / 10) {
+						index = SIZE_MAX;
+						break;
+					}
+					index = index * 10 + (c - u8'0');
+				}
+				step.index = index;
+			}
+			result.steps.push_back(step);
+
+			if (p == end) {
+				return result;
+			}
+			p++;
+		}
+	}
+
+	NdjsonReader::NdjsonReader(JsonReadMode mode, size_t chunk_size) : reader(mode), source(nullptr), input(new NdjsonInput) {
+		input->capacity = std::max<size_t>(chunk_size, 1);
+		input->data = std::make_unique_for_overwrite<char8_t[]>(input->capacity);
+		source = &input->file;
+	}
+
+	NdjsonReader::NdjsonReader(JsonSource& source, JsonReadMode mode, size_t chunk_size) : NdjsonReader(mode, chunk_size) {
+		this->source = &source;
+	}
+
+	NdjsonReader::NdjsonReader(NdjsonReader&& other) noexcept
+		: reader(std::move(other.reader)),
+		  source(other.source),
+		  input(std::exchange(other.input, nullptr)),
+		  line_number(other.line_number) {}
+
+	NdjsonReader::~NdjsonReader() {
+		delete input;
+	}
+
+	std::expected<NdjsonReader, JsonErrorCode> NdjsonReader::from_file(const char8_t* path, JsonReadMode mode, size_t chunk_size) {
+		std::FILE* file = OpenFile(path, "rb");
+		if (!file) {
+			return std::unexpected(JsonErrorCode::FileIOFailed);
+		}
+
+		NdjsonReader ndjson(mode, chunk_size);
+		ndjson.input->file.file = file;
+		return ndjson;
+	}
+
+	std::expected<JsonReader*, JsonErrorCode> NdjsonReader::next() {
+		auto& in = *input;
+		while (true) {
+			size_t record_end;
+			auto newline = static_cast<const char8_t*>(std::memchr(in.data.get() + in.scanned, u8'\n', in.end - in.scanned));
+			if (newline) {
+				record_end = newline - in.data.get();
+			} else if (in.eof) {
+				if (in.begin == in.end) {
+					return nullptr;
+				}
+				record_end = in.end;
+			} else {
+				in.scanned = in.end;
+				if (auto result = JsonImpl::fill(in, *source); !result.has_value()) {
+					return std::unexpected(result.error());
+				}
+				continue;
+			}
+
+			const size_t begin = std::exchange(in.begin, std::min(record_end + 1, in.end));
+			in.scanned = in.begin;
+			line_number++;
+
+			// blank lines carry no record, trailing \r of \r\n endings is whitespace to the parser
+			if (JsonScanner{in.data.get(), record_end}.skip_whitespace(begin) == record_end) {
+				continue;
+			}
+
+			reader.reset(u8string_view{in.data.get() + begin, record_end - begin});
+			if (!reader.lazy && !reader.document) {
+				return std::unexpected(JsonErrorCode::ParseFailed);
+			}
+			return &reader;
+		}
+	}
+
+	std::expected<void, JsonErrorCode> NdjsonReader::parse_parallel(u8string_view input, NdjsonCallback callback, void* context, const NdjsonParallelOptions& options) {
+		return JsonImpl::parse_parallel(input, callback, context, options);
+	}
+
+	std::expected<void, JsonErrorCode> NdjsonReader::parse_file_parallel(const char8_t* path, NdjsonCallback callback, void* context, const NdjsonParallelOptions& options) {
+		auto mapped = MapFile(path);
+		if (!mapped) {
+			return std::unexpected(JsonErrorCode::FileIOFailed);
+		}
+
+		auto result = JsonImpl::parse_parallel(u8string_view{mapped->data, mapped->size}, callback, context, options);
+		UnmapFile(mapped);
+		return result;
+	}
+
+	JsonDocumentFramer::JsonDocumentFramer() : document(JsonReadMode::Document), input(new JsonFramerInput) {}
+
+	JsonDocumentFramer::~JsonDocumentFramer() {
+		delete input;
+	}
+
+	bool JsonDocumentFramer::complete() const noexcept {
+		return input->complete;
+	}
+
+	std::expected<bool, JsonErrorCode> JsonDocumentFramer::feed(const char8_t* data, size_t size) {
+		if (input->complete) {
+			input->pending.append(data, size);
+			if (!document.document) {
+				return std::unexpected(JsonErrorCode::ParseFailed);
+			}
+			return true;
+		}
+
+		const size_t begin = input->buffer.size();
+		input->buffer.append(data, size);
+		return JsonImpl::scan_framed(*this, begin);
+	}
+
+	std::expected<bool, JsonErrorCode> JsonDocumentFramer::reset() {
+		JsonImpl::clear(document);
+		input->buffer.clear();
+		input->scanner.reset();
+		input->complete = false;
+
+		std::swap(input->buffer, input->pending);
+		return JsonImpl::scan_framed(*this, 0);
+	}
 }
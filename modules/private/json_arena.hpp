@@ -0,0 +1,161 @@
+#pragma once
+
+#include <new>
+#include <span>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+#include <yyjson.h>
+
+namespace auxiliary
+{
+	// Bump allocator behind yyjson_alc, blocks are kept by rewind() so that recycled documents don't touch the heap
+	class JsonArena {
+	public:
+		JsonArena() = default;
+
+		// serve from buffer first, then from the heap unless upstream is false. The front of buffer holds the block header,
+		// a buffer too small for it is left unused
+		JsonArena(std::span<std::byte> buffer, bool upstream) noexcept : upstream(upstream) {
+			const auto begin = align_up(reinterpret_cast<uintptr_t>(buffer.data()));
+			const auto end = reinterpret_cast<uintptr_t>(buffer.data() + buffer.size());
+			if (begin + align_up(sizeof(Block)) < end) {
+				external = reinterpret_cast<Block*>(begin);
+				external->next = nullptr;
+				external->capacity = end - begin - align_up(sizeof(Block));
+				external->used = 0;
+				head = external;
+			}
+		}
+
+		JsonArena(const JsonArena&) = delete;
+		JsonArena& operator=(const JsonArena&) = delete;
+
+		~JsonArena() {
+			release();
+		}
+
+		[[nodiscard]] yyjson_alc allocator() noexcept {
+			yyjson_alc alc;
+			alc.malloc = [](void* ctx, size_t size) { return static_cast<JsonArena*>(ctx)->allocate(size); };
+			alc.realloc = [](void* ctx, void* ptr, size_t old_size, size_t size) { return static_cast<JsonArena*>(ctx)->reallocate(ptr, old_size, size); };
+			alc.free = [](void*, void*) {};
+			alc.ctx = this;
+			return alc;
+		}
+
+		void* allocate(size_t size) {
+			size = align_up(size);
+			if (!head || head->used + size > head->capacity) {
+				if (!next_block(size)) {
+					return nullptr;
+				}
+			}
+
+			last = head->data() + head->used;
+			head->used += size;
+			return last;
+		}
+
+		void* reallocate(void* ptr, size_t old_size, size_t size) {
+			if (ptr == nullptr) {
+				return allocate(size);
+			}
+
+			// the most recent allocation can grow in place
+			if (ptr == last) {
+				const size_t offset = static_cast<std::byte*>(ptr) - head->data();
+				if (offset + align_up(size) <= head->capacity) {
+					head->used = offset + align_up(size);
+					return ptr;
+				}
+			}
+
+			void* result = allocate(size);
+			if (result) {
+				std::memcpy(result, ptr, old_size < size ? old_size : size);
+			}
+			return result;
+		}
+
+		// drop every allocation, keeping the heap memory for the next round in a single block
+		void rewind() noexcept {
+			if (head && head->next) {
+				size_t total = 0;
+				for (auto block = head; block != external; block = block->next) {
+					total += block->capacity;
+				}
+				release();
+				next_block(total);
+			}
+
+			last = nullptr;
+			if (head) {
+				head->used = 0;
+			}
+		}
+
+		// give the heap blocks back, the caller buffer is served from again
+		void release() noexcept {
+			while (head != external) {
+				auto next = head->next;
+				::operator delete(head);
+				head = next;
+			}
+			if (head) {
+				head->used = 0;
+			}
+			last = nullptr;
+		}
+
+	private:
+		// operator new already returns memory aligned for any scalar type
+		static constexpr size_t alignment = alignof(std::max_align_t);
+		static constexpr size_t min_block_size = 4096;
+
+		struct Block {
+			Block* next;
+			size_t capacity;
+			size_t used;
+
+			std::byte* data() noexcept {
+				return reinterpret_cast<std::byte*>(this) + align_up(sizeof(Block));
+			}
+		};
+
+		static constexpr size_t align_up(size_t size) noexcept {
+			return (size + alignment - 1) & ~(alignment - 1);
+		}
+
+		bool next_block(size_t size) noexcept {
+			if (!upstream) {
+				return false;
+			}
+
+			size_t capacity = head ? head->capacity * 2 : min_block_size;
+			while (capacity < size) {
+				capacity *= 2;
+			}
+
+			auto memory = ::operator new(align_up(sizeof(Block)) + capacity, std::nothrow);
+			if (!memory) {
+				return false;
+			}
+
+			auto block = static_cast<Block*>(memory);
+			block->next = head;
+			block->capacity = capacity;
+			block->used = 0;
+			head = block;
+			return true;
+		}
+
+		// newest block first, allocations are served from it
+		Block* head = nullptr;
+		void* last = nullptr;
+		// caller buffer at the end of the list, never deleted
+		Block* external = nullptr;
+		bool upstream = true;
+	};
+}
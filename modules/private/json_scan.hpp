@@ -0,0 +1,630 @@
+#pragma once
+
+#include "json_text.hpp"
+
+#include <auxiliary/json.hpp>
+
+#include <cstring>
+#include <charconv>
+
+namespace auxiliary
+{
+	// Number token classified the way yyjson reads it
+	struct JsonScanNumber {
+		enum EType {
+			kInvalid,
+			kSint,
+			kUint,
+			kReal
+		};
+
+		EType type = kInvalid;
+
+		union {
+			int64_t sint;
+			uint64_t uint;
+			double real;
+		};
+	};
+
+	// Skips and decodes single JSON values of a text without building a document, positions are byte offsets and npos marks an error
+	class JsonScanner {
+	public:
+		static constexpr size_t npos = static_cast<size_t>(-1);
+
+		JsonScanner() = default;
+		JsonScanner(const char8_t* data, size_t size) noexcept : text(data), length(size) {}
+
+		[[nodiscard]] const char8_t* data() const noexcept { return text; }
+		[[nodiscard]] size_t size() const noexcept { return length; }
+
+		[[nodiscard]] char8_t at(size_t pos) const noexcept { return pos < length ? text[pos] : u8'\0'; }
+
+		[[nodiscard]] size_t skip_whitespace(size_t pos) const noexcept {
+			while (pos < length && (text[pos] == u8' ' || text[pos] == u8'\n' || text[pos] == u8'\r' || text[pos] == u8'\t')) {
+				pos++;
+			}
+			return pos;
+		}
+
+		// pos is at the opening quote, returns the position after the closing one
+		[[nodiscard]] size_t skip_string(size_t pos) const noexcept {
+			const char8_t* const end = text + length;
+			for (const char8_t* p = text + pos + 1; (p = json_text::find_special<false>(p, end)) != end;) {
+				if (*p == u8'"') {
+					return p - text + 1;
+				}
+				if (*p != u8'\\' || end - p < 2) {
+					return npos;
+				}
+				p += 2;
+			}
+			return npos;
+		}
+
+		// brackets are only counted, which is enough to find the end of a well formed container
+		[[nodiscard]] size_t skip_container(size_t pos) const noexcept {
+			size_t depth = 0;
+			while (pos < length) {
+				const char8_t c = text[pos];
+				if (c == u8'"') {
+					pos = skip_string(pos);
+					if (pos == npos) {
+						return npos;
+					}
+					continue;
+				}
+
+				if (c == u8'{' || c == u8'[') {
+					depth++;
+				} else if (c == u8'}' || c == u8']') {
+					if (--depth == 0) {
+						return pos + 1;
+					}
+				}
+				pos++;
+			}
+			return npos;
+		}
+
+		// literals and numbers, which have to follow the JSON grammar like JsonValidator checks it and end where the value does
+		[[nodiscard]] size_t skip_scalar(size_t pos) const noexcept {
+			size_t end;
+			switch (at(pos)) {
+				case u8't':
+					end = skip_literal(pos, u8"true", 4);
+					break;
+				case u8'f':
+					end = skip_literal(pos, u8"false", 5);
+					break;
+				case u8'n':
+					end = skip_literal(pos, u8"null", 4);
+					break;
+				default: {
+					const char8_t* error;
+					const char8_t* last = pos < length ? json_text::number_end(text + pos, text + length, error) : nullptr;
+					end = last ? static_cast<size_t>(last - text) : npos;
+				}
+			}
+
+			if (end == npos || end == length) {
+				return end;
+			}
+			switch (text[end]) {
+				case u8' ':
+				case u8'\n':
+				case u8'\r':
+				case u8'\t':
+				case u8',':
+				case u8'}':
+				case u8']':
+					return end;
+				default:
+					return npos;
+			}
+		}
+
+		// pos is at the first character of the value, returns the position after it
+		[[nodiscard]] size_t skip_value(size_t pos) const noexcept {
+			switch (at(pos)) {
+				case u8'"':
+					return skip_string(pos);
+				case u8'{':
+				case u8'[':
+					return skip_container(pos);
+				default:
+					return skip_scalar(pos);
+			}
+		}
+
+		// pos is after a value, returns the position of the next member or element, or of the closing bracket
+		[[nodiscard]] size_t next_member(size_t pos) const noexcept {
+			pos = skip_whitespace(pos);
+			switch (at(pos)) {
+				case u8',':
+					pos = skip_whitespace(pos + 1);
+					return pos < length ? pos : npos;
+				case u8'}':
+				case u8']':
+					return pos;
+				default:
+					return npos;
+			}
+		}
+
+		// append the unescaped content of the string at pos to out, returns the position after the closing quote
+		[[nodiscard]] size_t read_string(size_t pos, JsonTextBuffer& out) const {
+			for (pos++; pos < length;) {
+				const char8_t c = text[pos];
+				if (c == u8'"') {
+					return pos + 1;
+				}
+				if (c < 0x20) {
+					return npos;
+				}
+				if (c != u8'\\') {
+					out.append(c);
+					pos++;
+					continue;
+				}
+
+				switch (at(pos + 1)) {
+					case u8'"': out.append(u8'"');
+						break;
+					case u8'\\': out.append(u8'\\');
+						break;
+					case u8'/': out.append(u8'/');
+						break;
+					case u8'b': out.append(u8'\b');
+						break;
+					case u8'f': out.append(u8'\f');
+						break;
+					case u8'n': out.append(u8'\n');
+						break;
+					case u8'r': out.append(u8'\r');
+						break;
+					case u8't': out.append(u8'\t');
+						break;
+					case u8'u': {
+						pos = read_unicode(pos, out);
+						if (pos == npos) {
+							return npos;
+						}
+						continue;
+					}
+					default:
+						return npos;
+				}
+				pos += 2;
+			}
+			return npos;
+		}
+
+		// compare the string at pos with key, end is set to the position after the closing quote
+		[[nodiscard]] bool string_equals(size_t pos, u8string_view key, JsonTextBuffer& scratch, size_t& end) const {
+			end = skip_string(pos);
+			if (end == npos) {
+				return false;
+			}
+
+			const char8_t* content = text + pos + 1;
+			const size_t raw_length = end - pos - 2;
+			if (std::memchr(content, u8'\\', raw_length) == nullptr) {
+				return raw_length == key.size() && std::memcmp(content, key.data(), raw_length) == 0;
+			}
+
+			scratch.clear();
+			end = read_string(pos, scratch);
+			return end != npos && scratch.size() == key.size() && std::memcmp(scratch.data(), key.data(), key.size()) == 0;
+		}
+
+		// integers which don't fit 64 bits become real numbers like in yyjson, anything from_chars takes beyond the
+		// JSON grammar (nan, inf, leading zeros, a plus sign) is invalid
+		[[nodiscard]] JsonScanNumber read_number(size_t pos, size_t end) const noexcept {
+			JsonScanNumber number;
+			const char8_t* error;
+			if (pos >= end || end > length || json_text::number_end(text + pos, text + end, error) != text + end) {
+				return number;
+			}
+
+			const char* first = reinterpret_cast<const char*>(text + pos);
+			const char* last = reinterpret_cast<const char*>(text + end);
+
+			if (std::find_if(first, last, [](char c) { return c == '.' || c == 'e' || c == 'E'; }) == last) {
+				if (*first == '-') {
+					if (auto [ptr, ec] = std::from_chars(first, last, number.sint); ec == std::errc{} && ptr == last) {
+						number.type = JsonScanNumber::kSint;
+						return number;
+					}
+				} else if (auto [ptr, ec] = std::from_chars(first, last, number.uint); ec == std::errc{} && ptr == last) {
+					number.type = JsonScanNumber::kUint;
+					return number;
+				}
+			}
+
+			if (auto [ptr, ec] = std::from_chars(first, last, number.real); ec == std::errc{} && ptr == last) {
+				number.type = JsonScanNumber::kReal;
+			}
+			return number;
+		}
+
+	private:
+		[[nodiscard]] size_t skip_literal(size_t pos, const char8_t* word, size_t size) const noexcept {
+			return length - pos >= size && std::memcmp(text + pos, word, size) == 0 ? pos + size : npos;
+		}
+
+		[[nodiscard]] static int hex_value(char8_t c) noexcept {
+			if (c >= u8'0' && c <= u8'9') return c - u8'0';
+			if (c >= u8'a' && c <= u8'f') return c - u8'a' + 10;
+			if (c >= u8'A' && c <= u8'F') return c - u8'A' + 10;
+			return -1;
+		}
+
+		[[nodiscard]] bool read_hex4(size_t pos, uint32_t& value) const noexcept {
+			if (pos + 4 > length) {
+				return false;
+			}
+
+			value = 0;
+			for (size_t i = 0; i < 4; i++) {
+				const int digit = hex_value(text[pos + i]);
+				if (digit < 0) {
+					return false;
+				}
+				value = value << 4 | static_cast<uint32_t>(digit);
+			}
+			return true;
+		}
+
+		// pos is at the backslash of \uXXXX, surrogate pairs are combined
+		[[nodiscard]] size_t read_unicode(size_t pos, JsonTextBuffer& out) const {
+			uint32_t code;
+			if (!read_hex4(pos + 2, code)) {
+				return npos;
+			}
+			pos += 6;
+
+			if (code >= 0xD800 && code <= 0xDBFF) {
+				uint32_t low;
+				if (at(pos) != u8'\\' || at(pos + 1) != u8'u' || !read_hex4(pos + 2, low) || low < 0xDC00 || low > 0xDFFF) {
+					return npos;
+				}
+				code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+				pos += 6;
+			} else if (code >= 0xDC00 && code <= 0xDFFF) {
+				return npos;
+			}
+
+			if (code < 0x80) {
+				out.append(static_cast<char8_t>(code));
+			} else if (code < 0x800) {
+				out.append(static_cast<char8_t>(0xC0 | code >> 6));
+				out.append(static_cast<char8_t>(0x80 | (code & 0x3F)));
+			} else if (code < 0x10000) {
+				out.append(static_cast<char8_t>(0xE0 | code >> 12));
+				out.append(static_cast<char8_t>(0x80 | (code >> 6 & 0x3F)));
+				out.append(static_cast<char8_t>(0x80 | (code & 0x3F)));
+			} else {
+				out.append(static_cast<char8_t>(0xF0 | code >> 18));
+				out.append(static_cast<char8_t>(0x80 | (code >> 12 & 0x3F)));
+				out.append(static_cast<char8_t>(0x80 | (code >> 6 & 0x3F)));
+				out.append(static_cast<char8_t>(0x80 | (code & 0x3F)));
+			}
+			return pos;
+		}
+
+		const char8_t* text = nullptr;
+		size_t length = 0;
+	};
+
+	// Finds where a document received in pieces ends, the state carries over between calls
+	class JsonBoundaryScanner {
+	public:
+		static constexpr size_t npos = JsonScanner::npos;
+
+		void reset() noexcept { *this = {}; }
+
+		// scan data[begin, end) which continues the bytes seen so far, returns the position after the document or npos while it is incomplete
+		// a root scalar other than a string only ends at the whitespace behind it
+		[[nodiscard]] size_t advance(const char8_t* data, size_t begin, size_t end) noexcept {
+			for (size_t pos = begin; pos < end; pos++) {
+				const char8_t c = data[pos];
+				if (in_string) {
+					if (escaped) {
+						escaped = false;
+					} else if (c == u8'\\') {
+						escaped = true;
+					} else if (c == u8'"') {
+						in_string = false;
+						if (depth == 0) {
+							return pos + 1;
+						}
+					}
+					continue;
+				}
+
+				const bool whitespace = c == u8' ' || c == u8'\n' || c == u8'\r' || c == u8'\t';
+				if (!started) {
+					if (whitespace) {
+						continue;
+					}
+					started = true;
+					if (c == u8'{' || c == u8'[') {
+						depth = 1;
+					} else if (c == u8'"') {
+						in_string = true;
+					} else {
+						scalar = true;
+					}
+					continue;
+				}
+
+				if (scalar) {
+					if (whitespace) {
+						return pos;
+					}
+					continue;
+				}
+
+				if (c == u8'"') {
+					in_string = true;
+				} else if (c == u8'{' || c == u8'[') {
+					depth++;
+				} else if (c == u8'}' || c == u8']') {
+					if (--depth == 0) {
+						return pos + 1;
+					}
+				}
+			}
+			return npos;
+		}
+
+	private:
+		size_t depth = 0;
+		bool started = false;
+		bool scalar = false;
+		bool in_string = false;
+		bool escaped = false;
+	};
+
+	// Checks text against the JSON grammar and UTF-8 without allocating, nesting deeper than max_depth is reported as an error
+	class JsonValidator {
+	public:
+		static constexpr size_t max_depth = 4096;
+
+		[[nodiscard]] static JsonStats validate(const char8_t* text, size_t length) noexcept {
+			JsonValidator validator{text, text + length};
+			return validator.run();
+		}
+
+	private:
+		JsonValidator(const char8_t* first, const char8_t* last) noexcept : begin(first), end(last) {}
+
+		JsonStats run() noexcept {
+			JsonStats stats;
+			size_t depth = 0;
+			bool expect_value = true;
+			const char8_t* p = skip_whitespace(begin);
+
+			while (true) {
+				if (expect_value) {
+					if (p == end) {
+						return fail(stats, p);
+					}
+
+					const char8_t c = *p;
+					if (c == u8'{' || c == u8'[') {
+						if (depth == max_depth) {
+							return fail(stats, p);
+						}
+						set_object(depth++, c == u8'{');
+						stats.value_count++;
+						stats.max_depth = std::max(stats.max_depth, depth);
+
+						p = skip_whitespace(p + 1);
+						if (p != end && *p == closing(depth)) {
+							depth--;
+							p++;
+							expect_value = false;
+						} else if (c == u8'{' && !(p = member(p))) {
+							return fail(stats, error);
+						}
+						continue;
+					}
+
+					switch (c) {
+						case u8'"': p = string(p);
+							break;
+						case u8't': p = literal(p, u8"true", 4);
+							break;
+						case u8'f': p = literal(p, u8"false", 5);
+							break;
+						case u8'n': p = literal(p, u8"null", 4);
+							break;
+						default: p = number(p);
+							break;
+					}
+					if (!p) {
+						return fail(stats, error);
+					}
+					stats.value_count++;
+					expect_value = false;
+					continue;
+				}
+
+				p = skip_whitespace(p);
+				if (depth == 0) {
+					return p == end ? stats : fail(stats, p);
+				}
+				if (p == end) {
+					return fail(stats, p);
+				}
+
+				if (*p == u8',') {
+					p = skip_whitespace(p + 1);
+					if (is_object(depth - 1) && !(p = member(p))) {
+						return fail(stats, error);
+					}
+					expect_value = true;
+				} else if (*p == closing(depth)) {
+					depth--;
+					p++;
+				} else {
+					return fail(stats, p);
+				}
+			}
+		}
+
+		JsonStats fail(JsonStats& stats, const char8_t* at) const noexcept {
+			stats.error_offset = static_cast<size_t>(at - begin);
+			return stats;
+		}
+
+		const char8_t* error_at(const char8_t* at) noexcept {
+			error = at;
+			return nullptr;
+		}
+
+		void set_object(size_t level, bool object) noexcept {
+			const uint64_t bit = uint64_t{1} << (level % 64);
+			kinds[level / 64] = object ? kinds[level / 64] | bit : kinds[level / 64] & ~bit;
+		}
+
+		[[nodiscard]] bool is_object(size_t level) const noexcept {
+			return kinds[level / 64] >> (level % 64) & 1;
+		}
+
+		[[nodiscard]] char8_t closing(size_t depth) const noexcept {
+			return is_object(depth - 1) ? u8'}' : u8']';
+		}
+
+		[[nodiscard]] const char8_t* skip_whitespace(const char8_t* p) const noexcept {
+			while (p != end && (*p == u8' ' || *p == u8'\n' || *p == u8'\r' || *p == u8'\t')) {
+				p++;
+			}
+			return p;
+		}
+
+		// key and colon of an object member, returns the start of its value
+		const char8_t* member(const char8_t* p) noexcept {
+			if (p == end || *p != u8'"') {
+				return error_at(p);
+			}
+			if (!(p = string(p))) {
+				return nullptr;
+			}
+
+			p = skip_whitespace(p);
+			if (p == end || *p != u8':') {
+				return error_at(p);
+			}
+			return skip_whitespace(p + 1);
+		}
+
+		const char8_t* string(const char8_t* p) noexcept {
+			for (p++;;) {
+				p = json_text::find_special<true>(p, end);
+				if (p == end) {
+					return error_at(p);
+				}
+
+				const char8_t c = *p;
+				if (c == u8'"') {
+					return p + 1;
+				}
+				if (c == u8'\\') {
+					p = escape(p);
+				} else if (c < 0x20) {
+					return error_at(p);
+				} else {
+					p = utf8(p);
+				}
+				if (!p) {
+					return nullptr;
+				}
+			}
+		}
+
+		const char8_t* escape(const char8_t* p) noexcept {
+			if (end - p < 2) {
+				return error_at(p);
+			}
+
+			switch (p[1]) {
+				case u8'"':
+				case u8'\\':
+				case u8'/':
+				case u8'b':
+				case u8'f':
+				case u8'n':
+				case u8'r':
+				case u8't':
+					return p + 2;
+				case u8'u': {
+					// like yyjson, a high surrogate needs a low one right after it and a low one never stands alone
+					uint32_t code, low;
+					if (!hex4(p, code) || (code >= 0xDC00 && code <= 0xDFFF)) {
+						return error_at(p);
+					}
+					if (code >= 0xD800 && code <= 0xDBFF) {
+						if (end - p < 8 || p[6] != u8'\\' || p[7] != u8'u' || !hex4(p + 6, low) || low < 0xDC00 || low > 0xDFFF) {
+							return error_at(p);
+						}
+						return p + 12;
+					}
+					return p + 6;
+				}
+				default:
+					return error_at(p);
+			}
+		}
+
+		// the four digits of the \uXXXX escape at p
+		bool hex4(const char8_t* p, uint32_t& value) const noexcept {
+			if (end - p < 6) {
+				return false;
+			}
+
+			value = 0;
+			for (size_t i = 2; i < 6; i++) {
+				const char8_t c = p[i];
+				uint32_t digit;
+				if (c >= u8'0' && c <= u8'9') {
+					digit = c - u8'0';
+				} else if (c >= u8'a' && c <= u8'f') {
+					digit = c - u8'a' + 10;
+				} else if (c >= u8'A' && c <= u8'F') {
+					digit = c - u8'A' + 10;
+				} else {
+					return false;
+				}
+				value = value << 4 | digit;
+			}
+			return true;
+		}
+
+		const char8_t* utf8(const char8_t* p) noexcept {
+			const size_t size = json_text::utf8_sequence(p, end);
+			return size ? p + size : error_at(p);
+		}
+
+		const char8_t* literal(const char8_t* p, const char8_t* word, size_t size) noexcept {
+			if (static_cast<size_t>(end - p) < size || std::memcmp(p, word, size) != 0) {
+				return error_at(p);
+			}
+			return p + size;
+		}
+
+		const char8_t* number(const char8_t* p) noexcept {
+			const char8_t* at;
+			const char8_t* last = json_text::number_end(p, end, at);
+			return last ? last : error_at(at);
+		}
+
+		const char8_t* begin;
+		const char8_t* end;
+		const char8_t* error = nullptr;
+		// bit per open level, set for objects
+		uint64_t kinds[max_depth / 64] = {};
+	};
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <auxiliary/string.hpp>
+#include <auxiliary/config/simd.h>
+
+#include <bit>
+#include <cmath>
+#include <memory>
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+
+#if defined(AUXILIARY_ARCH_SSE4_1)
+#	include <immintrin.h>
+#endif
+
+namespace auxiliary
+{
+	// Growable byte buffer for generated JSON text
+	class JsonTextBuffer {
+	public:
+		[[nodiscard]] const char8_t* data() const noexcept { return buffer.get(); }
+		[[nodiscard]] size_t size() const noexcept { return length; }
+		[[nodiscard]] size_t capacity() const noexcept { return space; }
+		[[nodiscard]] u8string_view view() const noexcept { return {buffer.get(), length}; }
+
+		void clear() noexcept { length = 0; }
+
+		// make room for n more bytes and return the write position
+		char8_t* reserve(size_t n) {
+			if (length + n > space) {
+				grow(length + n);
+			}
+			return buffer.get() + length;
+		}
+
+		void commit(size_t n) noexcept { length += n; }
+
+		// drop everything after the first n bytes
+		void truncate(size_t n) noexcept { length = std::min(length, n); }
+
+		void append(const void* data, size_t n) {
+			std::memcpy(reserve(n), data, n);
+			length += n;
+		}
+
+		void append(char8_t c) {
+			*reserve(1) = c;
+			length += 1;
+		}
+
+	private:
+		void grow(size_t required) {
+			size_t new_space = space < 256 ? 256 : space;
+			while (new_space < required) {
+				new_space *= 2;
+			}
+
+			auto new_buffer = std::make_unique_for_overwrite<char8_t[]>(new_space);
+			if (length > 0) {
+				std::memcpy(new_buffer.get(), buffer.get(), length);
+			}
+			buffer = std::move(new_buffer);
+			space = new_space;
+		}
+
+		std::unique_ptr<char8_t[]> buffer;
+		size_t length = 0;
+		size_t space = 0;
+	};
+
+	namespace json_text
+	{
+		// largest output of one escaped input byte (\u00XX)
+		inline constexpr size_t max_escape_expansion = 6;
+
+		// first byte of [first, last) that ends a plain run of string content: a quote, a backslash, a control character,
+		// and with NonAscii any byte of a multibyte UTF-8 sequence, last if there is none
+		template<bool NonAscii>
+		const char8_t* find_special(const char8_t* first, const char8_t* last) noexcept {
+#if defined(AUXILIARY_ARCH_AVX2)
+			const __m256i quote32 = _mm256_set1_epi8('"');
+			const __m256i backslash32 = _mm256_set1_epi8('\\');
+			const __m256i control32 = _mm256_set1_epi8(0x1F);
+			while (last - first >= 32) {
+				const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+				const __m256i special = _mm256_or_si256(
+					_mm256_or_si256(_mm256_cmpeq_epi8(v, quote32), _mm256_cmpeq_epi8(v, backslash32)),
+					_mm256_cmpeq_epi8(_mm256_min_epu8(v, control32), v));
+				uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(special));
+				if constexpr (NonAscii) {
+					mask |= static_cast<uint32_t>(_mm256_movemask_epi8(v));
+				}
+				if (mask) {
+					return first + std::countr_zero(mask);
+				}
+				first += 32;
+			}
+#endif
+#if defined(AUXILIARY_ARCH_SSE4_1)
+			const __m128i quote16 = _mm_set1_epi8('"');
+			const __m128i backslash16 = _mm_set1_epi8('\\');
+			const __m128i control16 = _mm_set1_epi8(0x1F);
+			while (last - first >= 16) {
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+				const __m128i special = _mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi8(v, quote16), _mm_cmpeq_epi8(v, backslash16)),
+					_mm_cmpeq_epi8(_mm_min_epu8(v, control16), v));
+				uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+				if constexpr (NonAscii) {
+					mask |= static_cast<uint32_t>(_mm_movemask_epi8(v));
+				}
+				if (mask) {
+					return first + std::countr_zero(mask);
+				}
+				first += 16;
+			}
+#endif
+			for (; first < last; ++first) {
+				const char8_t c = *first;
+				if (c == u8'"' || c == u8'\\' || c < 0x20 || (NonAscii && c >= 0x80)) {
+					return first;
+				}
+			}
+			return last;
+		}
+
+		// length of the multibyte UTF-8 sequence at p, 0 if it is malformed, overlong or a surrogate
+		inline size_t utf8_sequence(const char8_t* p, const char8_t* end) noexcept {
+			const char8_t lead = *p;
+			size_t size;
+			char8_t low = 0x80;
+			char8_t high = 0xBF;
+
+			if (lead >= 0xC2 && lead <= 0xDF) {
+				size = 2;
+			} else if (lead >= 0xE0 && lead <= 0xEF) {
+				size = 3;
+				low = lead == 0xE0 ? 0xA0 : 0x80;
+				high = lead == 0xED ? 0x9F : 0xBF;
+			} else if (lead >= 0xF0 && lead <= 0xF4) {
+				size = 4;
+				low = lead == 0xF0 ? 0x90 : 0x80;
+				high = lead == 0xF4 ? 0x8F : 0xBF;
+			} else {
+				return 0;
+			}
+
+			if (static_cast<size_t>(end - p) < size || p[1] < low || p[1] > high) {
+				return 0;
+			}
+			for (size_t i = 2; i < size; i++) {
+				if ((p[i] & 0xC0) != 0x80) {
+					return 0;
+				}
+			}
+			return size;
+		}
+
+		// end of the number at p by the JSON grammar -? (0 | [1-9][0-9]*) (.[0-9]+)? ([eE][+-]?[0-9]+)?,
+		// nullptr with error set to where it breaks
+		inline const char8_t* number_end(const char8_t* p, const char8_t* end, const char8_t*& error) noexcept {
+			auto digits = [&](const char8_t* q) {
+				while (q != end && *q >= u8'0' && *q <= u8'9') {
+					q++;
+				}
+				return q;
+			};
+
+			const char8_t* start = p;
+			if (p != end && *p == u8'-') {
+				p++;
+			}
+			if (p == end || *p < u8'0' || *p > u8'9') {
+				error = start;
+				return nullptr;
+			}
+			p = *p == u8'0' ? p + 1 : digits(p);
+
+			if (p != end && *p == u8'.') {
+				const char8_t* fraction = digits(p + 1);
+				if (fraction == p + 1) {
+					error = p;
+					return nullptr;
+				}
+				p = fraction;
+			}
+
+			if (p != end && (*p == u8'e' || *p == u8'E')) {
+				const char8_t* exponent = p + 1;
+				if (exponent != end && (*exponent == u8'+' || *exponent == u8'-')) {
+					exponent++;
+				}
+				const char8_t* last = digits(exponent);
+				if (last == exponent) {
+					error = p;
+					return nullptr;
+				}
+				p = last;
+			}
+			return p;
+		}
+
+		inline void write_bool(JsonTextBuffer& out, bool value) {
+			if (value) {
+				out.append(u8"true", 4);
+			} else {
+				out.append(u8"false", 5);
+			}
+		}
+
+		template<typename T> requires(std::is_integral_v<T>)
+		void write_integer(JsonTextBuffer& out, T value) {
+			char* first = reinterpret_cast<char*>(out.reserve(24));
+			auto [last, ec] = std::to_chars(first, first + 24, value);
+			out.commit(last - first);
+		}
+
+		// false for inf and nan, which have no JSON representation
+		inline bool write_real(JsonTextBuffer& out, double value) {
+			if (!std::isfinite(value)) {
+				return false;
+			}
+
+			char* first = reinterpret_cast<char*>(out.reserve(32));
+			auto [last, ec] = std::to_chars(first, first + 32, value);
+
+			// keep the value a real number when read back
+			if (std::find_if(first, last, [](char c) { return c == '.' || c == 'e' || c == 'E'; }) == last) {
+				*last++ = '.';
+				*last++ = '0';
+			}
+			out.commit(last - first);
+			return true;
+		}
+
+		// input bytes escaped per reservation, so a long string grows the output by what it needs and not by
+		// max_escape_expansion times its length
+		inline constexpr size_t escape_slice = 4096;
+
+		// write escaped content of a string without the surrounding quotes, runs without escapes are copied whole,
+		// false if str is not valid UTF-8
+		inline bool write_escaped(JsonTextBuffer& out, const char8_t* str, size_t len) {
+			static constexpr char8_t hex[] = u8"0123456789abcdef";
+
+			const char8_t* const end = str + len;
+			while (str != end) {
+				// a UTF-8 sequence may run up to 3 bytes past the slice
+				const char8_t* const slice_end = str + std::min<size_t>(end - str, escape_slice);
+				char8_t* dst = out.reserve((slice_end - str + 3) * max_escape_expansion);
+				char8_t* const begin = dst;
+
+				while (str < slice_end) {
+					const char8_t* special = find_special<true>(str, slice_end);
+					std::memcpy(dst, str, special - str);
+					dst += special - str;
+					str = special;
+					if (str == slice_end) {
+						break;
+					}
+
+					const char8_t c = *str;
+					if (c >= 0x80) {
+						const size_t size = utf8_sequence(str, end);
+						if (size == 0) {
+							out.commit(dst - begin);
+							return false;
+						}
+						std::memcpy(dst, str, size);
+						dst += size;
+						str += size;
+						continue;
+					}
+
+					*dst++ = u8'\\';
+					switch (c) {
+						case u8'"': *dst++ = u8'"';
+							break;
+						case u8'\\': *dst++ = u8'\\';
+							break;
+						case u8'\b': *dst++ = u8'b';
+							break;
+						case u8'\f': *dst++ = u8'f';
+							break;
+						case u8'\n': *dst++ = u8'n';
+							break;
+						case u8'\r': *dst++ = u8'r';
+							break;
+						case u8'\t': *dst++ = u8't';
+							break;
+						default:
+							*dst++ = u8'u';
+							*dst++ = u8'0';
+							*dst++ = u8'0';
+							*dst++ = hex[c >> 4];
+							*dst++ = hex[c & 0xF];
+							break;
+					}
+					str++;
+				}
+				out.commit(dst - begin);
+			}
+			return true;
+		}
+	}
+}
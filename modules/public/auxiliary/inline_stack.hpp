@@ -0,0 +1,130 @@
+#pragma once
+
+#include <memory>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <type_traits>
+
+namespace auxiliary
+{
+	// LIFO stack keeping its first N elements in place, it only allocates once it grows beyond them
+	template<typename T, size_t N>
+		requires(std::is_trivially_copyable_v<T> && N > 0)
+	class inline_stack {
+	public:
+		using value_type = T;
+		using size_type = size_t;
+		using reference = T&;
+		using const_reference = const T&;
+
+		inline_stack() noexcept = default;
+
+		inline_stack(const inline_stack& other) {
+			reserve(other.count);
+			copy(other);
+		}
+
+		inline_stack(inline_stack&& other) noexcept {
+			take(other);
+		}
+
+		inline_stack& operator=(const inline_stack& other) {
+			if (this != &other) {
+				count = 0;
+				reserve(other.count);
+				copy(other);
+			}
+			return *this;
+		}
+
+		inline_stack& operator=(inline_stack&& other) noexcept {
+			if (this != &other) {
+				release();
+				take(other);
+			}
+			return *this;
+		}
+
+		~inline_stack() {
+			release();
+		}
+
+		[[nodiscard]] bool empty() const noexcept { return count == 0; }
+		[[nodiscard]] size_type size() const noexcept { return count; }
+		[[nodiscard]] size_type capacity() const noexcept { return limit; }
+		[[nodiscard]] bool is_inline() const noexcept { return heap == nullptr; }
+
+		[[nodiscard]] reference top() noexcept { return data()[count - 1]; }
+		[[nodiscard]] const_reference top() const noexcept { return data()[count - 1]; }
+
+		void push(const T& value) { emplace(value); }
+
+		template<typename... Args>
+		reference emplace(Args&&... args) {
+			// built first, args may refer to an element that growing moves
+			T value(std::forward<Args>(args)...);
+			if (count == limit) {
+				grow(limit * 2);
+			}
+			return *std::construct_at(data() + count++, value);
+		}
+
+		void pop() noexcept { count--; }
+
+		// keeps the heap block, if any
+		void clear() noexcept { count = 0; }
+
+		void reserve(size_type capacity) {
+			if (capacity > limit) {
+				grow(capacity);
+			}
+		}
+
+	private:
+		T* data() noexcept { return heap ? heap : reinterpret_cast<T*>(buffer); }
+		const T* data() const noexcept { return heap ? heap : reinterpret_cast<const T*>(buffer); }
+
+		void grow(size_type capacity) {
+			T* block = std::allocator<T>().allocate(capacity);
+			if (count) {
+				std::memcpy(block, data(), count * sizeof(T));
+			}
+			release();
+			heap = block;
+			limit = capacity;
+		}
+
+		void release() noexcept {
+			if (heap) {
+				std::allocator<T>().deallocate(heap, limit);
+				heap = nullptr;
+				limit = N;
+			}
+		}
+
+		void copy(const inline_stack& other) noexcept {
+			if (other.count) {
+				std::memcpy(data(), other.data(), other.count * sizeof(T));
+			}
+			count = other.count;
+		}
+
+		// expects an inline, empty this
+		void take(inline_stack& other) noexcept {
+			if (other.heap) {
+				heap = std::exchange(other.heap, nullptr);
+				limit = std::exchange(other.limit, N);
+				count = std::exchange(other.count, 0);
+			} else {
+				copy(other);
+				other.count = 0;
+			}
+		}
+
+		T* heap = nullptr;
+		size_type count = 0;
+		size_type limit = N;
+		alignas(T) std::byte buffer[sizeof(T) * N];
+	};
+}
@@ -1,8 +1,15 @@
 #pragma once
 
 #include "string.hpp"
-
-#include <stack>
+#include "inline_stack.hpp"
+#include "config/string.h"
+
+#include <span>
+#include <cstddef>
+#include <tuple>
+#include <limits>
+#include <memory>
+#include <utility>
 #include <vector>
 #include <expected>
 
@@ -20,16 +27,230 @@ namespace auxiliary
 		PresetKeyNotConsumedYet, // RW
 		PresetKeyIsEmpty,        // RW
 
-		KeyNotFound,      // R
-		UnknownTypeToRead // R
+		KeyNotFound,       // R
+		UnknownTypeToRead, // R
+
+		SinkWriteFailed, // W
+		BufferTooSmall,  // RW
+		FileIOFailed,    // RW
+		ParseFailed,     // R
+		InvalidUtf8,     // W
+		ElementTypeMismatch, // R
+		ChildNotSpliceable,  // W
+		InvalidPath,         // R
+		NumberOutOfRange     // R
+	};
+
+	enum class JsonWriteMode : uint8_t {
+		Document, // build a yyjson document, serialized by dump()
+		Stream    // append JSON text directly as values are written
+	};
+
+	// Result of JsonReader::validate()
+	struct JsonStats {
+		static constexpr size_t no_error = static_cast<size_t>(-1);
+
+		// byte offset of the first invalid byte, the input size if it ends too early
+		size_t error_offset = no_error;
+		// deepest nesting of objects and arrays, enough level_depth for a JsonWriter rebuilding the document
+		size_t max_depth = 0;
+		// objects, arrays, strings, numbers and literals up to the error, keys not included
+		size_t value_count = 0;
+
+		[[nodiscard]] bool valid() const noexcept { return error_offset == no_error; }
+	};
+
+	// Where the last parse of a JsonReader failed, see JsonReader::parse_error()
+	struct JsonParseError {
+		static constexpr size_t no_error = static_cast<size_t>(-1);
+		static constexpr size_t excerpt_capacity = 64;
+
+		size_t offset = no_error;
+		// 1-based, column counts characters
+		size_t line = 0;
+		size_t column = 0;
+		// static text of the parser
+		const char* message = nullptr;
+		// input around offset, cut at character boundaries, excerpt_offset is where offset falls in it
+		char8_t excerpt[excerpt_capacity] = {};
+		size_t excerpt_length = 0;
+		size_t excerpt_offset = 0;
+
+		[[nodiscard]] u8string_view context() const noexcept { return {excerpt, excerpt_length}; }
+	};
+
+	// JSON Pointer ("/render/passes/3/format", with ~0 and ~1 escapes) or dotted path ("render.passes.3.format"),
+	// split and hashed once for JsonReader::resolve()
+	class AUXILIARY_API JsonPath {
+	public:
+		// a leading '/' selects JSON Pointer, an empty path is the value resolution starts from
+		static std::expected<JsonPath, JsonErrorCode> compile(u8string_view path);
+
+		[[nodiscard]] size_t size() const noexcept { return steps.size(); }
+
+	private:
+		friend struct JsonImpl;
+
+		struct Step {
+			size_t offset;
+			size_t length;
+			size_t hash;
+			// array position the key spells, SIZE_MAX if it is no index
+			size_t index;
+		};
+
+		std::vector<Step> steps;
+		// unescaped keys of all steps
+		std::vector<char8_t> keys;
+	};
+
+	// Value found by JsonReader::resolve(), strings live as long as the document of the reader. In OnDemand mode a string
+	// without escapes points into the input and has no terminator, an escaped one stays valid until the next read() or resolve()
+	struct JsonPathValue {
+		enum EType : uint8_t {
+			kMissing,
+			kNull,
+			kBool,
+			kSint,
+			kUint,
+			kReal,
+			kString,
+			kArray,
+			kObject
+		};
+
+		EType type = kMissing;
+
+		union {
+			bool boolean;
+			int64_t sint;
+			uint64_t uint = 0;
+			double real;
+		};
+
+		const char8_t* string = nullptr;
+		size_t length = 0;
+	};
+
+	enum class JsonReadMode : uint8_t {
+		Document,  // parse the whole input into a yyjson document up front
+		OnDemand,  // scan the input as values are read, skipping whatever is never visited
+		RawNumbers // like Document, but numbers keep their text and are only converted when read()
+	};
+
+	// Text of a number as it stands in the input, read in OnDemand or RawNumbers mode and written back without reformatting
+	struct JsonRawNumber {
+		const char8_t* text = nullptr;
+		size_t length = 0;
+
+		[[nodiscard]] u8string_view view() const noexcept { return {text, length}; }
+	};
+
+	class AUXILIARY_API JsonAllocator {
+	public:
+		virtual ~JsonAllocator() = default;
+
+		// memory must be aligned for any scalar type
+		virtual void* allocate(size_t size) = 0;
+		// defaults to allocate, copy and deallocate
+		virtual void* reallocate(void* ptr, size_t old_size, size_t size);
+		virtual void deallocate(void* ptr) noexcept = 0;
+	};
+
+	// Bump allocator, deallocate() is a no-op and release() drops every allocation at once
+	class AUXILIARY_API JsonMonotonicAllocator final : public JsonAllocator {
+	public:
+		JsonMonotonicAllocator();
+		// serve from buffer first, then from the heap unless upstream is false
+		// memory only grows until release(), a writer that reset()s in a loop needs a release() between documents
+		explicit JsonMonotonicAllocator(std::span<std::byte> buffer, bool upstream = true);
+		~JsonMonotonicAllocator() override;
+
+		JsonMonotonicAllocator(const JsonMonotonicAllocator&) = delete;
+		JsonMonotonicAllocator& operator=(const JsonMonotonicAllocator&) = delete;
+
+		void* allocate(size_t size) override;
+		void* reallocate(void* ptr, size_t old_size, size_t size) override;
+		void deallocate(void*) noexcept override {}
+
+		void release() noexcept;
+
+	private:
+		// the same bump allocator that backs documents without a user allocator
+		class JsonArena* arena;
+	};
+
+	class AUXILIARY_API JsonSink {
+	public:
+		virtual ~JsonSink() = default;
+
+		// return false to make the writer fail with SinkWriteFailed
+		virtual bool write(const char8_t* data, size_t size) = 0;
+	};
+
+	class AUXILIARY_API JsonSource {
+	public:
+		virtual ~JsonSource() = default;
+
+		// fill up to capacity bytes of buffer and set size, 0 at the end of the input, return false to fail with FileIOFailed
+		virtual bool read(char8_t* buffer, size_t capacity, size_t& size) = 0;
+	};
+
+	// Key known at compile time (e.g. a string literal), it outlives every document so it is referenced instead of copied
+	class JsonStaticKey {
+	public:
+		consteval explicit JsonStaticKey(u8string_view key) noexcept : key(key), key_hash(Hash<u8string_view>()(key)) {}
+
+		[[nodiscard]] constexpr u8string_view view() const noexcept { return key; }
+		[[nodiscard]] constexpr size_t hash() const noexcept { return key_hash; }
+
+	private:
+		u8string_view key;
+		size_t key_hash;
+	};
+
+	// Member of T written and read under a key known at compile time
+	template<typename T, typename M>
+	struct JsonField {
+		JsonStaticKey key;
+		M T::* member;
 	};
 
+	// Specialize with `static constexpr auto fields = std::tuple{JsonField...}`, most simply through AUXILIARY_JSON_FIELDS,
+	// and T becomes readable and writable as an object with those members
+	template<typename T>
+	struct JsonFields;
+
+	template<typename T>
+	struct JsonFieldCodec;
+
+	template<typename T>
+	concept JsonReflectable = requires { JsonFields<T>::fields; };
+
+#define AUXILIARY_JSON_FIELD(type, member) \
+	::auxiliary::JsonField<type, decltype(type::member)>{::auxiliary::JsonStaticKey{MAKE_UTF8(member)}, &type::member}
+
+	// AUXILIARY_JSON_FIELDS(Vec3, AUXILIARY_JSON_FIELD(Vec3, x), AUXILIARY_JSON_FIELD(Vec3, y)) at global scope
+#define AUXILIARY_JSON_FIELDS(type, ...) \
+	template<> struct auxiliary::JsonFields<type> { static constexpr auto fields = std::tuple{__VA_ARGS__}; }
+
+	class JsonReader;
+
 	class AUXILIARY_API JsonWriter {
 	public:
-		// reserve for stack
+		// reserve for stack, 16 levels need no allocation
 		explicit JsonWriter(size_t level_depth);
+		JsonWriter(size_t level_depth, JsonWriteMode mode);
+		// stream mode, text is handed to sink whenever more than chunk_size bytes are pending
+		JsonWriter(size_t level_depth, JsonSink& sink, size_t chunk_size = 64 * 1024);
+		// document memory comes from allocator, which must outlive the writer, dump() text lives in the writer's own arena
+		// reset() frees the document to allocator, a JsonMonotonicAllocator only gets that back on release()
+		JsonWriter(size_t level_depth, JsonAllocator& allocator);
 		~JsonWriter();
 
+		// start a new document, keeping the memory of the previous one for reuse
+		void reset();
+
 		std::expected<void, JsonErrorCode> start_object(u8string_view key);
 		std::expected<void, JsonErrorCode> start_array(u8string_view key);
 		std::expected<void, JsonErrorCode> end_array() noexcept;
@@ -40,23 +261,92 @@ namespace auxiliary
 		std::expected<void, JsonErrorCode> write(u8string_view key, uint64_t value);
 		std::expected<void, JsonErrorCode> write(u8string_view key, double value);
 		std::expected<void, JsonErrorCode> write(u8string_view key, const char8_t* value, size_t len);
+		// the text is copied as it is, text that isn't exactly one JSON number is rejected
+		std::expected<void, JsonErrorCode> write(u8string_view key, const JsonRawNumber& value);
 
+		// write a whole array under key in one call, the array is left open for more elements like after start_array()
+		// and end_array() closes it
 		std::expected<void, JsonErrorCode> write(size_t count, u8string_view key, const bool* value);
+		std::expected<void, JsonErrorCode> write(size_t count, u8string_view key, const int8_t* value);
+		std::expected<void, JsonErrorCode> write(size_t count, u8string_view key, const int16_t* value);
+		std::expected<void, JsonErrorCode> write(size_t count, u8string_view key, const int32_t* value);
 		std::expected<void, JsonErrorCode> write(size_t count, u8string_view key, const int64_t* value);
+		std::expected<void, JsonErrorCode> write(size_t count, u8string_view key, const uint8_t* value);
+		std::expected<void, JsonErrorCode> write(size_t count, u8string_view key, const uint16_t* value);
+		std::expected<void, JsonErrorCode> write(size_t count, u8string_view key, const uint32_t* value);
 		std::expected<void, JsonErrorCode> write(size_t count, u8string_view key, const uint64_t* value);
+		std::expected<void, JsonErrorCode> write(size_t count, u8string_view key, const float* value);
 		std::expected<void, JsonErrorCode> write(size_t count, u8string_view key, const double* value);
 		std::expected<void, JsonErrorCode> write(size_t count, u8string_view key, const char8_t** value, const size_t* len);
 
+		// put the finished root object of child into the open scope under key and reset child, so that subtrees can be built
+		// by writers on other threads and spliced in order. In document mode the subtree is adopted as is and its memory is kept
+		// until this writer is reset or destroyed, so an allocator child uses must outlive this writer. A stream mode child
+		// needs a stream mode parent and no sink, and in a stream mode parent the subtree is copied as text
+		std::expected<void, JsonErrorCode> splice(u8string_view key, JsonWriter& child);
+
+		// start over with the document of reader to change it through set(), insert() and remove() before dump(). A document
+		// mode reader is copied. An on demand reader is validated and referenced as raw text, which is only split into members
+		// where paths lead, so its input must outlive this writer too. Stream mode writers return ScopeTypeMismatch
+		std::expected<void, JsonErrorCode> edit(const JsonReader& reader);
+
+		// edits of the finished root, also one this writer built. set() replaces the value at path or adds its last key, insert()
+		// puts the value before an array index or at the end and is set() on objects. Values are those of write(), nullptr,
+		// JsonRawNumber and JsonPathValue, whose kArray and kObject become empty containers
+		template<typename T>
+		std::expected<void, JsonErrorCode> set(const JsonPath& path, const T& value);
+		template<typename T>
+		std::expected<void, JsonErrorCode> insert(const JsonPath& path, const T& value);
+		std::expected<void, JsonErrorCode> remove(const JsonPath& path);
+
+		// stream mode with sink only, hand pending text to sink (done automatically when the root closes)
+		std::expected<void, JsonErrorCode> flush();
+
+		// asserts and returns empty text if serialization fails, dump_to() hands the error to the caller
 		[[nodiscard]] u8string dump() const;
+		// serialize into caller storage (reusing its capacity), returns the number of bytes written
+		std::expected<size_t, JsonErrorCode> dump_to(u8string& out) const;
+		std::expected<size_t, JsonErrorCode> dump_to(std::span<char8_t> out) const;
+		std::expected<void, JsonErrorCode> dump_to_file(const char8_t* path) const;
 
 		template<typename... Args>
 		std::expected<void, JsonErrorCode> write(u8string_view key, Args&&... args);
 
+		// element types without a bulk overload are written one by one, the array is left open as well
 		template<typename... Args>
 		std::expected<void, JsonErrorCode> write(size_t count, u8string_view key, Args&&... args);
 
+		std::expected<void, JsonErrorCode> start_object(JsonStaticKey key);
+		std::expected<void, JsonErrorCode> start_array(JsonStaticKey key);
+
+		template<typename... Args>
+		std::expected<void, JsonErrorCode> write(JsonStaticKey key, Args&&... args);
+
+		template<typename... Args>
+		std::expected<void, JsonErrorCode> write(size_t count, JsonStaticKey key, Args&&... args);
+
 	private:
 		friend struct JsonImpl;
+		template<typename T>
+		friend struct JsonFieldCodec;
+
+		enum class EPatch : uint8_t {
+			kSet,
+			kInsert,
+			kRemove
+		};
+
+		template<typename T>
+		std::expected<void, JsonErrorCode> patch(const JsonPath& path, EPatch mode, const T& value);
+		// raw marks string as the text of a JsonRawNumber
+		std::expected<void, JsonErrorCode> patch(const JsonPath& path, EPatch mode, const JsonPathValue& value, bool raw);
+
+		// members of the object JsonFieldCodec opened, the scope was checked once for all of them
+		std::expected<void, JsonErrorCode> write_field(JsonStaticKey key, bool value);
+		std::expected<void, JsonErrorCode> write_field(JsonStaticKey key, int64_t value);
+		std::expected<void, JsonErrorCode> write_field(JsonStaticKey key, uint64_t value);
+		std::expected<void, JsonErrorCode> write_field(JsonStaticKey key, double value);
+		std::expected<void, JsonErrorCode> write_field(JsonStaticKey key, const char8_t* value, size_t len);
 
 		struct Level {
 			enum EType {
@@ -66,12 +356,24 @@ namespace auxiliary
 
 			struct JsonWriterValue* value;
 			EType type;
+			// elements written so far, used by stream mode for comma placement
+			uint32_t count = 0;
 
 			Level(JsonWriterValue* _value, EType _type) noexcept : value(_value), type(_type) {}
 		};
 
-		struct JsonWriterDocument* document;
-		std::vector<Level> stack;
+		struct JsonWriterDocument* document = nullptr;
+		struct JsonWriterStream* stream = nullptr;
+		// backs document, recycled by reset()
+		class JsonArena* arena = nullptr;
+		JsonAllocator* allocator = nullptr;
+		// recycled output memory of dump()
+		mutable class JsonArena* scratch = nullptr;
+		// documents of spliced children, their values are linked into document
+		struct JsonWriterAdopted* adopted = nullptr;
+		// key of the static key call in flight, it is not copied when it reaches the document
+		const char8_t* borrowed_key = nullptr;
+		inline_stack<Level, 16> stack;
 	};
 
 	class AUXILIARY_API JsonReader {
@@ -80,18 +382,55 @@ namespace auxiliary
 		explicit JsonReader(u8string_view json);
 		explicit JsonReader(const u8string& json);
 		JsonReader(const char8_t* json, size_t len);
+		// document memory comes from allocator, which must outlive the reader
+		JsonReader(u8string_view json, JsonAllocator& allocator);
+		JsonReader(const char8_t* json, size_t len, JsonAllocator& allocator);
+		// parse in place, strings are unescaped into buffer and read() returns pointers into it, so buffer must outlive the reader
+		// the first len bytes hold the JSON and buffer needs insitu_padding more bytes behind them, otherwise the input is copied
+		JsonReader(std::span<char8_t> buffer, size_t len);
+		JsonReader(std::span<char8_t> buffer, size_t len, JsonAllocator& allocator);
+		// on demand mode scans json where it is, so it must outlive the reader, and malformed input is only reported where it is visited
+		JsonReader(u8string_view json, JsonReadMode mode);
+		JsonReader(JsonReader&& other) noexcept;
+		JsonReader& operator=(JsonReader&& other) noexcept;
+		JsonReader(const JsonReader&) = delete;
+		JsonReader& operator=(const JsonReader&) = delete;
 		~JsonReader();
 
+		// parse a read-only memory mapped file, it is unmapped once the document holds a copy
+		static std::expected<JsonReader, JsonErrorCode> from_file(const char8_t* path);
+		static std::expected<JsonReader, JsonErrorCode> from_file(const char8_t* path, JsonAllocator& allocator);
+
+		static constexpr size_t insitu_padding = 4;
+
+		// check grammar and UTF-8 without building a document or allocating
+		static JsonStats validate(u8string_view json) noexcept;
+
+		// details of the last failed parse, nullptr if it succeeded, on demand mode reports errors where they are visited instead
+		[[nodiscard]] const JsonParseError* parse_error() const noexcept;
+		// log failed parses with their excerpt, never the whole input, off by default
+		static void set_error_logging(bool enabled) noexcept;
+
+		// parse another document, keeping the memory of the previous one for reuse
+		void reset(u8string_view new_input);
+		void reset(std::span<char8_t> buffer, size_t len);
+
 		std::expected<void, JsonErrorCode> start_object(u8string_view key);
 		std::expected<size_t, JsonErrorCode> start_array(u8string_view key);
 		std::expected<void, JsonErrorCode> end_array() noexcept;
 		std::expected<void, JsonErrorCode> end_object() noexcept;
 
+		// integers that don't fit return NumberOutOfRange and leave value as it is
 		std::expected<void, JsonErrorCode> read(u8string_view key, bool& value);
 		std::expected<void, JsonErrorCode> read(u8string_view key, int64_t& value);
 		std::expected<void, JsonErrorCode> read(u8string_view key, uint64_t& value);
 		std::expected<void, JsonErrorCode> read(u8string_view key, double& value);
+		// in OnDemand mode the string stays valid until the next read() or resolve()
 		std::expected<void, JsonErrorCode> read(u8string_view key, const char8_t*& value);
+		// in OnDemand mode a string without escapes is a view into the input, others stay valid until the next read() or resolve()
+		std::expected<void, JsonErrorCode> read(u8string_view key, u8string_view& value);
+		// Document mode keeps no number text and returns UnknownTypeToRead, a value other than a number is an ElementTypeMismatch
+		std::expected<void, JsonErrorCode> read(u8string_view key, JsonRawNumber& value);
 
 		template<typename T>
 		std::expected<void, JsonErrorCode> read(u8string_view key, T& value);
@@ -99,8 +438,54 @@ namespace auxiliary
 		template<typename T>
 		std::expected<void, JsonErrorCode> read(size_t count, T* values);
 
+		// store count elements straight into values, an element of another type or out of range returns ElementTypeMismatch and
+		// its index in mismatch, counted from values[0], fewer than count elements left return KeyNotFound. Every element is
+		// checked before the first is stored, so on failure values and the position in the array are left as they were
+		std::expected<void, JsonErrorCode> read(size_t count, bool* values, size_t* mismatch = nullptr);
+		std::expected<void, JsonErrorCode> read(size_t count, int8_t* values, size_t* mismatch = nullptr);
+		std::expected<void, JsonErrorCode> read(size_t count, int16_t* values, size_t* mismatch = nullptr);
+		std::expected<void, JsonErrorCode> read(size_t count, int32_t* values, size_t* mismatch = nullptr);
+		std::expected<void, JsonErrorCode> read(size_t count, int64_t* values, size_t* mismatch = nullptr);
+		std::expected<void, JsonErrorCode> read(size_t count, uint8_t* values, size_t* mismatch = nullptr);
+		std::expected<void, JsonErrorCode> read(size_t count, uint16_t* values, size_t* mismatch = nullptr);
+		std::expected<void, JsonErrorCode> read(size_t count, uint32_t* values, size_t* mismatch = nullptr);
+		std::expected<void, JsonErrorCode> read(size_t count, uint64_t* values, size_t* mismatch = nullptr);
+		std::expected<void, JsonErrorCode> read(size_t count, float* values, size_t* mismatch = nullptr);
+		std::expected<void, JsonErrorCode> read(size_t count, double* values, size_t* mismatch = nullptr);
+
+		// lookups use the hash computed at compile time
+		std::expected<void, JsonErrorCode> start_object(JsonStaticKey key);
+		std::expected<size_t, JsonErrorCode> start_array(JsonStaticKey key);
+
+		template<typename T>
+		std::expected<void, JsonErrorCode> read(JsonStaticKey key, T& value);
+
+		// value at path from the open scope, or from the root when none is open, the stack is left as it is
+		std::expected<JsonPathValue, JsonErrorCode> resolve(const JsonPath& path);
+		// values[i] receives paths[i], kMissing if it leads nowhere, and prefixes shared by several paths are walked once
+		std::expected<void, JsonErrorCode> resolve(std::span<const JsonPath> paths, std::span<JsonPathValue> values);
+
+		// objects with more than threshold keys get a hash index on their first lookup, SIZE_MAX turns it off
+		void set_key_index_threshold(size_t threshold) noexcept { key_index_threshold = threshold; }
+
 	private:
 		friend struct JsonImpl;
+		friend class NdjsonReader;
+		friend class JsonDocumentFramer;
+		template<typename T>
+		friend struct JsonFieldCodec;
+
+		// members of the object JsonFieldCodec opened, the scope was checked once for all of them
+		std::expected<void, JsonErrorCode> read_field(JsonStaticKey key, bool& value);
+		std::expected<void, JsonErrorCode> read_field(JsonStaticKey key, int64_t& value);
+		std::expected<void, JsonErrorCode> read_field(JsonStaticKey key, uint64_t& value);
+		std::expected<void, JsonErrorCode> read_field(JsonStaticKey key, double& value);
+		std::expected<void, JsonErrorCode> read_field(JsonStaticKey key, const char8_t*& value);
+		std::expected<void, JsonErrorCode> read_field(JsonStaticKey key, u8string_view& value);
+
+		JsonReader() = default;
+		// no input yet, reset() provides it
+		explicit JsonReader(JsonReadMode mode);
 
 		struct Level {
 			enum EType {
@@ -110,13 +495,125 @@ namespace auxiliary
 
 			uint32_t index = 0;
 			struct JsonReaderValue* value;
+			// last visited element, so that sequential array reads don't restart from the head
+			// for objects the key after the last match, which is tried first since fields are mostly read in written order
+			JsonReaderValue* cursor = nullptr;
+			// 1-based table of key_index, 0 until the first lookup in a large object
+			uint32_t key_table = 0;
+			// whether a cursor match may stand for a lookup, which finds the first of duplicated keys
+			enum EKeys : uint8_t {
+				kKeysUnchecked,
+				kKeysUnique,
+				kKeysDuplicated
+			};
+			EKeys keys = kKeysUnchecked;
 			EType type;
 
 			Level(JsonReaderValue* _value, EType _type) noexcept : value(_value), type(_type) {}
 		};
 
-		struct JsonReaderDocument* document;
-		std::stack<Level> stack;
+		struct JsonReaderDocument* document = nullptr;
+		// backs document, recycled by reset()
+		class JsonArena* arena = nullptr;
+		JsonAllocator* allocator = nullptr;
+		// scan state of on demand mode, document stays empty then
+		struct JsonLazyDocument* lazy = nullptr;
+		// hash tables over the keys of large objects, kept until the document goes away
+		struct JsonKeyIndex* key_index = nullptr;
+		size_t key_index_threshold = 32;
+		// key of the static key call in flight, its hash is known already
+		const JsonStaticKey* static_key = nullptr;
+		// allocated by the first failed parse and reused by later ones
+		JsonParseError* failure = nullptr;
+		// RawNumbers mode
+		bool raw_numbers = false;
+		inline_stack<Level, 16> stack;
+	};
+
+	struct NdjsonParallelOptions {
+		// 0 picks std::thread::hardware_concurrency()
+		size_t threads = 0;
+		// deliver records in input order, otherwise each worker delivers as soon as it has parsed a record
+		bool ordered = true;
+		// input bytes per work item, extended to the next line end
+		size_t chunk_size = 1024 * 1024;
+		// receives the earliest record that failed, offset and line count from the start of the input
+		JsonParseError* error = nullptr;
+	};
+
+	// reader of one record and the byte offset of the record in the input
+	using NdjsonCallback = void (*)(void* context, JsonReader& reader, size_t offset);
+
+	// Reads newline delimited JSON, one document per line, through a single recycled JsonReader
+	class AUXILIARY_API NdjsonReader {
+	public:
+		// the input is pulled from source in chunks of chunk_size bytes, a longer record grows the buffer to fit
+		explicit NdjsonReader(JsonSource& source, JsonReadMode mode = JsonReadMode::Document, size_t chunk_size = 64 * 1024);
+		NdjsonReader(NdjsonReader&& other) noexcept;
+		NdjsonReader& operator=(NdjsonReader&&) = delete;
+		~NdjsonReader();
+
+		static std::expected<NdjsonReader, JsonErrorCode> from_file(const char8_t* path, JsonReadMode mode = JsonReadMode::Document, size_t chunk_size = 64 * 1024);
+
+		// reader of the next record, valid until the next call, nullptr at the end of the input
+		// a record that fails to parse returns ParseFailed and the following call moves on to the next one
+		std::expected<JsonReader*, JsonErrorCode> next();
+
+		// 1-based line of the current record
+		[[nodiscard]] size_t line() const noexcept { return line_number; }
+
+		// parse records on several threads, callback runs on the worker threads and reader is only valid during the call
+		// the callback calls are serialized when ordered, otherwise they run concurrently
+		// every record that parses is delivered, ParseFailed is returned afterward if any did not
+		// an exception thrown by callback stops the other workers and is rethrown here once they are joined
+		template<typename F>
+		static std::expected<void, JsonErrorCode> parse_parallel(u8string_view input, F&& callback, const NdjsonParallelOptions& options = {});
+		template<typename F>
+		static std::expected<void, JsonErrorCode> parse_file_parallel(const char8_t* path, F&& callback, const NdjsonParallelOptions& options = {});
+
+		static std::expected<void, JsonErrorCode> parse_parallel(u8string_view input, NdjsonCallback callback, void* context, const NdjsonParallelOptions& options);
+		static std::expected<void, JsonErrorCode> parse_file_parallel(const char8_t* path, NdjsonCallback callback, void* context, const NdjsonParallelOptions& options);
+
+	private:
+		friend struct JsonImpl;
+
+		// reads the file source owned by input
+		NdjsonReader(JsonReadMode mode, size_t chunk_size);
+
+		JsonReader reader;
+		JsonSource* source;
+		struct NdjsonInput* input;
+		size_t line_number = 0;
+	};
+
+	// Buffers a document received in pieces and frames it: a piece is only scanned for the end of the document on arrival,
+	// the whole document is parsed in place after its last byte. No parse work overlaps with receiving, yyjson_incr_read()
+	// would need the total length up front
+	class AUXILIARY_API JsonDocumentFramer {
+	public:
+		JsonDocumentFramer();
+		JsonDocumentFramer(const JsonDocumentFramer&) = delete;
+		JsonDocumentFramer& operator=(const JsonDocumentFramer&) = delete;
+		~JsonDocumentFramer();
+
+		// true once the document is complete and reader() is ready, bytes received after it are kept for the next document
+		// a root number or literal is only complete once whitespace follows it, ParseFailed until reset() if it did not parse
+		std::expected<bool, JsonErrorCode> feed(const char8_t* data, size_t size);
+		std::expected<bool, JsonErrorCode> feed(u8string_view chunk) { return feed(chunk.data(), chunk.size()); }
+
+		// the completed document, valid until reset()
+		[[nodiscard]] JsonReader& reader() noexcept { return document; }
+		[[nodiscard]] bool complete() const noexcept;
+
+		// drop the completed document and carry on with the bytes that followed it, true if they hold another complete document,
+		// ParseFailed if that one does not parse
+		std::expected<bool, JsonErrorCode> reset();
+
+	private:
+		friend struct JsonImpl;
+
+		JsonReader document;
+		struct JsonFramerInput* input;
 	};
 }
 
@@ -156,6 +653,10 @@ namespace auxiliary
 			return w.write(key, static_cast<double>(value));
 		}
 
+		inline std::expected<void, JsonErrorCode> write(JsonWriter& w, u8string_view key, const JsonRawNumber& value) {
+			return w.write(key, value);
+		}
+
 		inline std::expected<void, JsonErrorCode> write(JsonWriter& w, u8string_view key, const char8_t* value) {
 			return w.write(key, value, std::char_traits<char8_t>::length(value));
 		}
@@ -168,6 +669,22 @@ namespace auxiliary
 			return w.write(key, value.data(), value.size());
 		}
 
+		template<typename T>
+		concept JsonNativeArrayElement = std::is_same_v<T, bool> || std::is_same_v<T, float> || std::is_same_v<T, double> ||
+		                                 std::is_same_v<T, int8_t> || std::is_same_v<T, int16_t> || std::is_same_v<T, int32_t> || std::is_same_v<T, int64_t> ||
+		                                 std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t> || std::is_same_v<T, uint32_t> || std::is_same_v<T, uint64_t>;
+
+		// mutable pointers and arrays would otherwise pick the per element template over the const overloads
+		template<typename T> requires(JsonNativeArrayElement<T>)
+		std::expected<void, JsonErrorCode> write(JsonWriter& w, size_t count, u8string_view key, const T* values) {
+			return w.write(count, key, values);
+		}
+
+		template<typename T> requires(JsonReflectable<T>)
+		std::expected<void, JsonErrorCode> write(JsonWriter& w, u8string_view key, const T& value) {
+			return JsonFieldCodec<T>::write(w, key, value);
+		}
+
 		template<typename... Args>
 		concept JsonWritable = requires(JsonWriter& w, u8string_view key, Args&&... args)
 		{
@@ -183,53 +700,53 @@ namespace auxiliary
 
 	namespace json
 	{
-		inline std::expected<void, JsonErrorCode> read(JsonReader& r, u8string_view key, int8_t& value) {
-			int64_t tmp;
+		// value is only assigned if wide fits T, reals beyond the range of float count as out of range too
+		template<typename T, typename Wide>
+		std::expected<void, JsonErrorCode> narrow(Wide wide, T& value) noexcept {
+			if constexpr (std::is_floating_point_v<T>) {
+				if (wide > std::numeric_limits<T>::max() || wide < std::numeric_limits<T>::lowest()) {
+					return std::unexpected(JsonErrorCode::NumberOutOfRange);
+				}
+			} else if (!std::in_range<T>(wide)) {
+				return std::unexpected(JsonErrorCode::NumberOutOfRange);
+			}
+			value = static_cast<T>(wide);
+			return {};
+		}
+
+		template<typename Wide, typename T>
+		std::expected<void, JsonErrorCode> read_narrowed(JsonReader& r, u8string_view key, T& value) {
+			Wide tmp;
 			auto result = r.read(key, tmp);
-			value = static_cast<int8_t>(tmp);
-			return result;
+			return result.has_value() ? narrow(tmp, value) : result;
+		}
+
+		inline std::expected<void, JsonErrorCode> read(JsonReader& r, u8string_view key, int8_t& value) {
+			return read_narrowed<int64_t>(r, key, value);
 		}
 
 		inline std::expected<void, JsonErrorCode> read(JsonReader& r, u8string_view key, int16_t& value) {
-			int64_t tmp;
-			auto result = r.read(key, tmp);
-			value = static_cast<int16_t>(tmp);
-			return result;
+			return read_narrowed<int64_t>(r, key, value);
 		}
 
 		inline std::expected<void, JsonErrorCode> read(JsonReader& r, u8string_view key, int32_t& value) {
-			int64_t tmp;
-			auto result = r.read(key, tmp);
-			value = static_cast<int32_t>(tmp);
-			return result;
+			return read_narrowed<int64_t>(r, key, value);
 		}
 
 		inline std::expected<void, JsonErrorCode> read(JsonReader& r, u8string_view key, uint8_t& value) {
-			uint64_t tmp;
-			auto result = r.read(key, tmp);
-			value = static_cast<uint8_t>(tmp);
-			return result;
+			return read_narrowed<uint64_t>(r, key, value);
 		}
 
 		inline std::expected<void, JsonErrorCode> read(JsonReader& r, u8string_view key, uint16_t& value) {
-			uint64_t tmp;
-			auto result = r.read(key, tmp);
-			value = static_cast<uint16_t>(tmp);
-			return result;
+			return read_narrowed<uint64_t>(r, key, value);
 		}
 
 		inline std::expected<void, JsonErrorCode> read(JsonReader& r, u8string_view key, uint32_t& value) {
-			uint64_t tmp;
-			auto result = r.read(key, tmp);
-			value = static_cast<uint32_t>(tmp);
-			return result;
+			return read_narrowed<uint64_t>(r, key, value);
 		}
 
 		inline std::expected<void, JsonErrorCode> read(JsonReader& r, u8string_view key, float& value) {
-			double tmp;
-			auto result = r.read(key, tmp);
-			value = static_cast<float>(tmp);
-			return result;
+			return read_narrowed<double>(r, key, value);
 		}
 
 		inline std::expected<void, JsonErrorCode> read(JsonReader& r, u8string_view key, long double& value) {
@@ -244,19 +761,21 @@ namespace auxiliary
 		}
 
 		inline std::expected<void, JsonErrorCode> read(JsonReader& r, u8string_view key, u8string_view& value) {
-			const char8_t* tmp;
-			auto result = r.read(key, tmp);
-			value = tmp;
-			return result;
+			return r.read(key, value);
 		}
 
 		inline std::expected<void, JsonErrorCode> read(JsonReader& r, u8string_view key, u8string& value) {
-			const char8_t* tmp;
+			u8string_view tmp;
 			auto result = r.read(key, tmp);
-			if (result.has_value()) value = tmp;
+			if (result.has_value()) value = u8string(tmp);
 			return result;
 		}
 
+		template<typename T> requires(JsonReflectable<T>)
+		std::expected<void, JsonErrorCode> read(JsonReader& r, u8string_view key, T& value) {
+			return JsonFieldCodec<T>::read(r, key, value);
+		}
+
 		template<typename T>
 		concept JsonReadable = requires(JsonReader& r, u8string_view key, T& value)
 		{
@@ -264,6 +783,68 @@ namespace auxiliary
 		};
 	}
 
+	template<typename T>
+	struct JsonFieldCodec {
+		static std::expected<void, JsonErrorCode> write(JsonWriter& w, u8string_view key, const T& value) {
+			auto result = w.start_object(key);
+			if (result.has_value()) {
+				std::apply([&](const auto&... field) {
+					(void) ((result = write_member(w, field.key, value.*field.member)).has_value() && ...);
+				}, JsonFields<T>::fields);
+			}
+			return result.has_value() ? w.end_object() : result;
+		}
+
+		static std::expected<void, JsonErrorCode> read(JsonReader& r, u8string_view key, T& value) {
+			auto result = r.start_object(key);
+			if (result.has_value()) {
+				std::apply([&](const auto&... field) {
+					(void) ((result = read_member(r, field.key, value.*field.member)).has_value() && ...);
+				}, JsonFields<T>::fields);
+			}
+			return result.has_value() ? r.end_object() : result;
+		}
+
+	private:
+		// scalars and strings skip the per call checks, anything else takes the public path
+		template<typename M>
+		static std::expected<void, JsonErrorCode> write_member(JsonWriter& w, const JsonStaticKey& key, const M& member) {
+			if constexpr (std::is_same_v<M, bool>) {
+				return w.write_field(key, member);
+			} else if constexpr (std::is_integral_v<M> && std::is_signed_v<M>) {
+				return w.write_field(key, static_cast<int64_t>(member));
+			} else if constexpr (std::is_integral_v<M>) {
+				return w.write_field(key, static_cast<uint64_t>(member));
+			} else if constexpr (std::is_floating_point_v<M>) {
+				return w.write_field(key, static_cast<double>(member));
+			} else if constexpr (std::is_same_v<M, u8string> || std::is_same_v<M, u8string_view>) {
+				return w.write_field(key, member.data(), member.size());
+			} else {
+				return w.write(key, member);
+			}
+		}
+
+		template<typename M>
+		static std::expected<void, JsonErrorCode> read_member(JsonReader& r, const JsonStaticKey& key, M& member) {
+			if constexpr (std::is_same_v<M, bool>) {
+				return r.read_field(key, member);
+			} else if constexpr (std::is_arithmetic_v<M>) {
+				using Wide = std::conditional_t<std::is_floating_point_v<M>, double, std::conditional_t<std::is_signed_v<M>, int64_t, uint64_t>>;
+				Wide tmp;
+				auto result = r.read_field(key, tmp);
+				return result.has_value() ? json::narrow(tmp, member) : result;
+			} else if constexpr (std::is_same_v<M, u8string>) {
+				// by length, an escaped \u0000 is part of the string
+				u8string_view tmp;
+				auto result = r.read_field(key, tmp);
+				if (result.has_value() && tmp.data()) member.assign(tmp.data(), tmp.size());
+				return result;
+			} else {
+				return r.read(key, member);
+			}
+		}
+	};
+
 	template<typename... Args>
 	std::expected<void, JsonErrorCode> JsonWriter::write(u8string_view key, Args&&... args) {
 		static_assert(json::JsonWritable<Args...>);
@@ -290,12 +871,129 @@ namespace auxiliary
 		}
 	}
 
+	inline std::expected<void, JsonErrorCode> JsonWriter::start_object(JsonStaticKey key) {
+		const char8_t* previous = std::exchange(borrowed_key, key.view().data());
+		auto result = start_object(key.view());
+		borrowed_key = previous;
+		return result;
+	}
+
+	inline std::expected<void, JsonErrorCode> JsonWriter::start_array(JsonStaticKey key) {
+		const char8_t* previous = std::exchange(borrowed_key, key.view().data());
+		auto result = start_array(key.view());
+		borrowed_key = previous;
+		return result;
+	}
+
+	template<typename... Args>
+	std::expected<void, JsonErrorCode> JsonWriter::write(JsonStaticKey key, Args&&... args) {
+		const char8_t* previous = std::exchange(borrowed_key, key.view().data());
+		auto result = this->write(key.view(), std::forward<Args>(args)...);
+		borrowed_key = previous;
+		return result;
+	}
+
+	template<typename... Args>
+	std::expected<void, JsonErrorCode> JsonWriter::write(size_t count, JsonStaticKey key, Args&&... args) {
+		const char8_t* previous = std::exchange(borrowed_key, key.view().data());
+		auto result = this->write(count, key.view(), std::forward<Args>(args)...);
+		borrowed_key = previous;
+		return result;
+	}
+
+	template<typename T>
+	std::expected<void, JsonErrorCode> JsonWriter::set(const JsonPath& path, const T& value) {
+		return patch(path, EPatch::kSet, value);
+	}
+
+	template<typename T>
+	std::expected<void, JsonErrorCode> JsonWriter::insert(const JsonPath& path, const T& value) {
+		return patch(path, EPatch::kInsert, value);
+	}
+
+	template<typename T>
+	std::expected<void, JsonErrorCode> JsonWriter::patch(const JsonPath& path, EPatch mode, const T& value) {
+		JsonPathValue v;
+		if constexpr (std::is_same_v<T, JsonPathValue>) {
+			v = value;
+		} else if constexpr (std::is_same_v<T, JsonRawNumber>) {
+			v.type = JsonPathValue::kString;
+			v.string = value.text;
+			v.length = value.length;
+			return patch(path, mode, v, true);
+		} else if constexpr (std::is_same_v<T, std::nullptr_t>) {
+			v.type = JsonPathValue::kNull;
+		} else if constexpr (std::is_same_v<T, bool>) {
+			v.type = JsonPathValue::kBool;
+			v.boolean = value;
+		} else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+			v.type = JsonPathValue::kSint;
+			v.sint = value;
+		} else if constexpr (std::is_integral_v<T>) {
+			v.type = JsonPathValue::kUint;
+			v.uint = value;
+		} else if constexpr (std::is_floating_point_v<T>) {
+			v.type = JsonPathValue::kReal;
+			v.real = static_cast<double>(value);
+		} else if constexpr (std::is_convertible_v<const T&, const char8_t*>) {
+			v.type = JsonPathValue::kString;
+			v.string = value;
+			v.length = std::char_traits<char8_t>::length(value);
+		} else {
+			static_assert(std::is_same_v<T, u8string> || std::is_same_v<T, u8string_view>, "set() and insert() take scalars, strings, JsonRawNumber and JsonPathValue");
+			v.type = JsonPathValue::kString;
+			v.string = value.data();
+			v.length = value.size();
+		}
+		return patch(path, mode, v, false);
+	}
+
+	inline std::expected<void, JsonErrorCode> JsonReader::start_object(JsonStaticKey key) {
+		const JsonStaticKey* previous = std::exchange(static_key, &key);
+		auto result = start_object(key.view());
+		static_key = previous;
+		return result;
+	}
+
+	inline std::expected<size_t, JsonErrorCode> JsonReader::start_array(JsonStaticKey key) {
+		const JsonStaticKey* previous = std::exchange(static_key, &key);
+		auto result = start_array(key.view());
+		static_key = previous;
+		return result;
+	}
+
+	template<typename T>
+	std::expected<void, JsonErrorCode> JsonReader::read(JsonStaticKey key, T& value) {
+		const JsonStaticKey* previous = std::exchange(static_key, &key);
+		auto result = this->read(key.view(), value);
+		static_key = previous;
+		return result;
+	}
+
 	inline JsonReader::JsonReader(const char8_t* json) : JsonReader(u8string_view{json}) {}
 
+	template<typename F>
+	std::expected<void, JsonErrorCode> NdjsonReader::parse_parallel(u8string_view input, F&& callback, const NdjsonParallelOptions& options) {
+		using Callback = std::remove_reference_t<F>;
+		return parse_parallel(input, [](void* context, JsonReader& reader, size_t offset) {
+			(*static_cast<Callback*>(context))(reader, offset);
+		}, const_cast<void*>(static_cast<const void*>(std::addressof(callback))), options);
+	}
+
+	template<typename F>
+	std::expected<void, JsonErrorCode> NdjsonReader::parse_file_parallel(const char8_t* path, F&& callback, const NdjsonParallelOptions& options) {
+		using Callback = std::remove_reference_t<F>;
+		return parse_file_parallel(path, [](void* context, JsonReader& reader, size_t offset) {
+			(*static_cast<Callback*>(context))(reader, offset);
+		}, const_cast<void*>(static_cast<const void*>(std::addressof(callback))), options);
+	}
+
 	inline JsonReader::JsonReader(u8string_view json) : JsonReader(json.data(), json.size()) {}
 
 	inline JsonReader::JsonReader(const u8string& json): JsonReader(json.data(), json.size()) {}
 
+	inline JsonReader::JsonReader(u8string_view json, JsonAllocator& allocator) : JsonReader(json.data(), json.size(), allocator) {}
+
 	template<typename T>
 	std::expected<void, JsonErrorCode> JsonReader::read(u8string_view key, T& value) {
 		static_assert(json::JsonReadable<T>);
@@ -13,6 +13,10 @@ do
     add_packages("yyjson")
     add_packages("u8lib", { public = true })
 
+    if (is_os("linux")) then
+        add_syslinks("pthread")
+    end
+
     add_files("private/*.cpp")
     add_includedirs("public", { public = true })
     add_headerfiles("public/(**)")
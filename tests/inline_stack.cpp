@@ -0,0 +1,78 @@
+#include <doctest/doctest.h>
+#include <auxiliary/inline_stack.hpp>
+
+struct InlineStackTests {
+	struct Level {
+		int depth;
+		const void* value;
+
+		Level(int depth, const void* value) noexcept : depth(depth), value(value) {}
+	};
+
+	using Stack = auxiliary::inline_stack<Level, 4>;
+};
+
+TEST_CASE_FIXTURE(InlineStackTests, "PushPop") {
+	Stack stack;
+	CHECK(stack.empty());
+	CHECK(stack.is_inline());
+
+	for (int i = 0; i < 4; i++) {
+		stack.emplace(i, nullptr);
+	}
+	CHECK(stack.is_inline());
+	CHECK_EQ(stack.top().depth, 3);
+
+	// the fifth element moves everything to the heap
+	stack.push(stack.top());
+	CHECK_FALSE(stack.is_inline());
+	CHECK_EQ(stack.size(), 5u);
+	CHECK_EQ(stack.top().depth, 3);
+
+	stack.pop();
+	stack.pop();
+	CHECK_EQ(stack.top().depth, 2);
+
+	const size_t capacity = stack.capacity();
+	stack.clear();
+	CHECK(stack.empty());
+	CHECK_EQ(stack.capacity(), capacity);
+}
+
+TEST_CASE_FIXTURE(InlineStackTests, "Reserve") {
+	Stack stack;
+	stack.reserve(2);
+	CHECK(stack.is_inline());
+	CHECK_EQ(stack.capacity(), 4u);
+
+	stack.emplace(1, nullptr);
+	stack.reserve(32);
+	CHECK_FALSE(stack.is_inline());
+	CHECK_EQ(stack.capacity(), 32u);
+	CHECK_EQ(stack.top().depth, 1);
+}
+
+TEST_CASE_FIXTURE(InlineStackTests, "CopyMove") {
+	for (int count : {2, 6}) {
+		Stack stack;
+		for (int i = 0; i < count; i++) {
+			stack.emplace(i, &stack);
+		}
+
+		Stack copy = stack;
+		CHECK_EQ(copy.size(), stack.size());
+		CHECK_EQ(copy.top().depth, count - 1);
+
+		Stack moved = std::move(stack);
+		CHECK(stack.empty());
+		CHECK(stack.is_inline());
+		CHECK_EQ(moved.size(), static_cast<size_t>(count));
+		CHECK_EQ(moved.top().value, &stack);
+
+		copy.pop();
+		moved = std::move(copy);
+		CHECK_EQ(moved.top().depth, count - 2);
+		copy = moved;
+		CHECK_EQ(copy.size(), moved.size());
+	}
+}
@@ -3,6 +3,12 @@
 #include <u8lib/log.hpp>
 #include <auxiliary/json.hpp>
 
+#include <cmath>
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <stdexcept>
+
 #define U8LIB_STRINGIZING(...)			#__VA_ARGS__
 #define U8LIB_MAKE_STRING(...)			U8LIB_STRINGIZING(__VA_ARGS__)
 #define U8LIB_FILE_LINE					__FILE__ ":" U8LIB_MAKE_STRING(__LINE__)
@@ -346,3 +352,1228 @@ TEST_CASE_FIXTURE(JSONTests, "write errors") {
 		CHECK_ERROR(obj_writer.start_object(u8"key"), JsonErrorCode::RootObjectWithKey);
 	}
 }
+
+TEST_CASE_FIXTURE(JSONTests, "sequential array") {
+	using namespace auxiliary;
+
+	constexpr size_t count = 1000;
+
+	JsonWriter writer(3);
+	CHECK_OK(writer.start_object(u8""));
+	CHECK_OK(writer.start_array(u8"values"));
+	for (size_t i = 0; i < count; i++) {
+		if (i % 2 == 0) {
+			CHECK_OK(writer.start_object(u8""));
+			CHECK_OK(writer.write(u8"id", static_cast<uint64_t>(i)));
+			CHECK_OK(writer.end_object());
+		} else {
+			CHECK_OK(writer.start_array(u8""));
+			CHECK_OK(writer.write(u8"", static_cast<int64_t>(i)));
+			CHECK_OK(writer.end_array());
+		}
+	}
+	CHECK_OK(writer.end_array());
+	CHECK_OK(writer.end_object());
+
+	auto json = writer.dump();
+	JsonReader reader(json);
+	CHECK_OK(reader.start_object(u8""));
+	auto size = reader.start_array(u8"values");
+	CHECK_OK(size);
+	CHECK_EQ(size.value(), count);
+	for (size_t i = 0; i < count; i++) {
+		if (i % 2 == 0) {
+			uint64_t id;
+			CHECK_OK(reader.start_object(u8""));
+			CHECK_OK(reader.read(u8"id", id));
+			CHECK_EQ(id, i);
+			CHECK_OK(reader.end_object());
+		} else {
+			int64_t value;
+			CHECK_OK(reader.start_array(u8""));
+			CHECK_OK(reader.read(u8"", value));
+			CHECK_EQ(value, static_cast<int64_t>(i));
+			CHECK_OK(reader.end_array());
+		}
+	}
+	CHECK_ERROR(reader.start_object(u8""), JsonErrorCode::KeyNotFound);
+	CHECK_OK(reader.end_array());
+	CHECK_OK(reader.end_object());
+}
+
+TEST_CASE_FIXTURE(JSONTests, "stream writer") {
+	using namespace auxiliary;
+
+	struct StringSink : JsonSink {
+		std::u8string text;
+		size_t calls = 0;
+
+		bool write(const char8_t* data, size_t size) override {
+			text.append(data, size);
+			calls++;
+			return true;
+		}
+	};
+
+	auto produce = [](JsonWriter& writer) {
+		const double reals[] = {1.0, -2.5};
+		CHECK_OK(writer.start_object(u8""));
+		CHECK_OK(writer.write(u8"flag", true));
+		CHECK_OK(writer.write(u8"int", static_cast<int64_t>(-42)));
+		CHECK_OK(writer.write(u8"text", u8string_view{u8"quote\" slash\\ line\n 😀"}));
+		CHECK_OK(writer.start_array(u8"list"));
+		CHECK_OK(writer.write(u8"", static_cast<uint64_t>(7)));
+		CHECK_OK(writer.start_object(u8""));
+		CHECK_OK(writer.end_object());
+		CHECK_OK(writer.end_array());
+		CHECK_OK(writer.write(2, u8"reals", reals));
+		CHECK_OK(writer.end_array());
+		CHECK_ERROR(writer.write(u8"nan", std::nan("")), JsonErrorCode::UnknownError);
+		// one bad element rejects the whole array before anything is written
+		const double with_infinity[] = {1.0, std::numeric_limits<double>::infinity()};
+		CHECK_ERROR(writer.write(2, u8"infinity", with_infinity), JsonErrorCode::UnknownError);
+		CHECK_OK(writer.end_object());
+	};
+
+	JsonWriter document_writer(3);
+	produce(document_writer);
+
+	JsonWriter stream_writer(3, JsonWriteMode::Stream);
+	produce(stream_writer);
+
+	StringSink sink;
+	if (true) {
+		JsonWriter sink_writer(3, sink, 16);
+		produce(sink_writer);
+	}
+	CHECK_GT(sink.calls, 1);
+	CHECK_VALUE(stream_writer.dump(), u8string_view{sink.text.data(), sink.text.size()});
+
+	for (const auto& json : {document_writer.dump(), stream_writer.dump()}) {
+		JsonReader reader(json);
+		bool flag;
+		int64_t i;
+		u8string text;
+		uint64_t u;
+		double reals[2];
+		CHECK_OK(reader.start_object(u8""));
+		CHECK_OK(reader.read(u8"flag", flag));
+		CHECK_OK(reader.read(u8"int", i));
+		CHECK_OK(reader.read(u8"text", text));
+		CHECK_VALUE(flag, true);
+		CHECK_VALUE(i, -42);
+		CHECK_VALUE(text, u8string_view{u8"quote\" slash\\ line\n 😀"});
+		CHECK_OK(reader.start_array(u8"list"));
+		CHECK_OK(reader.read(u8"", u));
+		CHECK_VALUE(u, 7);
+		CHECK_OK(reader.end_array());
+		CHECK_OK(reader.start_array(u8"reals"));
+		CHECK_OK(reader.read(2, reals));
+		CHECK_VALUE(reals[0], 1.0);
+		CHECK_VALUE(reals[1], -2.5);
+		CHECK_OK(reader.end_array());
+		CHECK_OK(reader.end_object());
+	}
+
+	// end_object() is noexcept, a sink that throws when the root closes is reported like one that fails
+	struct ThrowingSink : JsonSink {
+		bool write(const char8_t*, size_t) override {
+			throw std::runtime_error("sink");
+		}
+	};
+	ThrowingSink throwing;
+	JsonWriter throwing_writer(1, throwing);
+	CHECK_OK(throwing_writer.start_object(u8""));
+	CHECK_ERROR(throwing_writer.end_object(), JsonErrorCode::SinkWriteFailed);
+	CHECK_ERROR(throwing_writer.flush(), JsonErrorCode::SinkWriteFailed);
+}
+
+TEST_CASE_FIXTURE(JSONTests, "dump to") {
+	using namespace auxiliary;
+
+	for (auto mode : {JsonWriteMode::Document, JsonWriteMode::Stream}) {
+		JsonWriter writer(1, mode);
+		CHECK_OK(writer.start_object(u8""));
+		CHECK_OK(writer.write(u8"key", u8string_view{u8"value"}));
+		CHECK_OK(writer.end_object());
+
+		const u8string expected = writer.dump();
+
+		u8string out = u8"previous content that is longer than the document";
+		auto size = writer.dump_to(out);
+		CHECK_OK(size);
+		CHECK_EQ(size.value(), expected.size());
+		CHECK_VALUE(out, expected);
+
+		char8_t small[4];
+		CHECK_ERROR(writer.dump_to(std::span<char8_t>{small}), JsonErrorCode::BufferTooSmall);
+
+		char8_t large[64];
+		size = writer.dump_to(std::span<char8_t>{large});
+		CHECK_OK(size);
+		CHECK_VALUE(u8string_view{large, size.value()}, expected);
+
+		CHECK_OK(writer.dump_to_file(u8"json_dump_to.json"));
+	}
+}
+
+TEST_CASE_FIXTURE(JSONTests, "reset") {
+	using namespace auxiliary;
+
+	JsonWriter writer(2);
+	JsonReader reader(u8"{}");
+	u8string json;
+
+	for (int64_t i = 0; i < 100; i++) {
+		writer.reset();
+		CHECK_OK(writer.start_object(u8""));
+		CHECK_OK(writer.write(u8"index", i));
+		CHECK_OK(writer.start_array(u8"list"));
+		for (int64_t j = 0; j < i; j++) {
+			CHECK_OK(writer.write(u8"", j));
+		}
+		CHECK_OK(writer.end_array());
+		CHECK_OK(writer.end_object());
+		CHECK_OK(writer.dump_to(json));
+
+		reader.reset(json);
+		int64_t index;
+		CHECK_OK(reader.start_object(u8""));
+		CHECK_OK(reader.read(u8"index", index));
+		CHECK_EQ(index, i);
+		auto size = reader.start_array(u8"list");
+		CHECK_OK(size);
+		CHECK_EQ(size.value(), static_cast<size_t>(i));
+		CHECK_OK(reader.end_array());
+		// left open on purpose, reset() has to drop the scope
+	}
+
+	JsonWriter stream_writer(1, JsonWriteMode::Stream);
+	CHECK_OK(stream_writer.start_object(u8""));
+	CHECK_OK(stream_writer.end_object());
+	stream_writer.reset();
+	CHECK_OK(stream_writer.start_object(u8""));
+	CHECK_OK(stream_writer.end_object());
+	CHECK_VALUE(stream_writer.dump(), u8string_view{u8"{}"});
+}
+
+TEST_CASE_FIXTURE(JSONTests, "allocator") {
+	using namespace auxiliary;
+
+	struct CountingAllocator : JsonAllocator {
+		size_t live = 0;
+		size_t total = 0;
+
+		void* allocate(size_t size) override {
+			live++;
+			total++;
+			return std::malloc(size);
+		}
+
+		void deallocate(void* ptr) noexcept override {
+			live--;
+			std::free(ptr);
+		}
+	};
+
+	CountingAllocator counting;
+	alignas(std::max_align_t) std::byte stack_buffer[16 * 1024];
+	JsonMonotonicAllocator monotonic(stack_buffer);
+
+	for (JsonAllocator* allocator : {static_cast<JsonAllocator*>(&counting), static_cast<JsonAllocator*>(&monotonic)}) {
+		u8string json;
+		if (true) {
+			JsonWriter writer(2, *allocator);
+			CHECK_OK(writer.start_object(u8""));
+			CHECK_OK(writer.write(u8"name", u8string_view{u8"arena"}));
+			CHECK_OK(writer.start_array(u8"values"));
+			for (int64_t i = 0; i < 64; i++) {
+				CHECK_OK(writer.write(u8"", i));
+			}
+			CHECK_OK(writer.end_array());
+			CHECK_OK(writer.end_object());
+			CHECK_OK(writer.dump_to(json));
+		}
+
+		if (true) {
+			JsonReader reader(json, *allocator);
+			u8string name;
+			int64_t values[64];
+			CHECK_OK(reader.start_object(u8""));
+			CHECK_OK(reader.read(u8"name", name));
+			CHECK_VALUE(name, u8string_view{u8"arena"});
+			CHECK_OK(reader.start_array(u8"values"));
+			CHECK_OK(reader.read(64, values));
+			CHECK_EQ(values[63], 63);
+			CHECK_OK(reader.end_array());
+			CHECK_OK(reader.end_object());
+		}
+	}
+
+	CHECK_GT(counting.total, 0);
+	CHECK_EQ(counting.live, 0);
+	monotonic.release();
+
+	std::byte tiny[16];
+	JsonMonotonicAllocator bounded(tiny, false);
+	CHECK_EQ(bounded.allocate(1024), nullptr);
+
+	// repeated dumps take nothing from the allocator, a bounded one does not run dry
+	alignas(std::max_align_t) std::byte document_buffer[4 * 1024];
+	JsonMonotonicAllocator document_only(document_buffer, false);
+	JsonWriter writer(2, document_only);
+	CHECK_OK(writer.start_object(u8""));
+	CHECK_OK(writer.write(u8"name", u8string_view{u8"arena"}));
+	CHECK_OK(writer.end_object());
+	u8string json;
+	for (int i = 0; i < 10000; i++) {
+		CHECK_OK(writer.dump_to(json));
+	}
+	CHECK_VALUE(json, u8string_view{u8R"({"name":"arena"})"});
+}
+
+TEST_CASE_FIXTURE(JSONTests, "static key") {
+	using namespace auxiliary;
+
+	static constexpr JsonStaticKey name_key{u8"name"};
+	static constexpr JsonStaticKey values_key{u8"values"};
+	static_assert(name_key.hash() == Hash<u8string_view>()(u8string_view{u8"name"}));
+
+	const int64_t values[] = {1, 2, 3};
+
+	for (auto mode : {JsonWriteMode::Document, JsonWriteMode::Stream}) {
+		JsonWriter writer(3, mode);
+		CHECK_OK(writer.start_object(u8""));
+		CHECK_OK(writer.write(name_key, u8string_view{u8"static"}));
+		CHECK_OK(writer.write(JsonStaticKey{u8"flag"}, true));
+		CHECK_OK(writer.write(JsonStaticKey{u8"small"}, static_cast<int32_t>(-3)));
+		CHECK_OK(writer.write(3, values_key, values));
+		CHECK_OK(writer.end_array());
+		CHECK_OK(writer.start_object(JsonStaticKey{u8"child"}));
+		CHECK_OK(writer.write(u8"copied", static_cast<uint64_t>(1)));
+		CHECK_OK(writer.end_object());
+		CHECK_ERROR(writer.start_array(JsonStaticKey{u8""}), JsonErrorCode::EmptyObjectFieldKey);
+		CHECK_OK(writer.end_object());
+
+		JsonReader reader(writer.dump());
+		u8string name;
+		bool flag;
+		int32_t small;
+		uint64_t copied;
+		CHECK_OK(reader.start_object(u8""));
+		CHECK_OK(reader.read(u8"name", name));
+		CHECK_OK(reader.read(u8"flag", flag));
+		CHECK_OK(reader.read(u8"small", small));
+		CHECK_VALUE(name, u8string_view{u8"static"});
+		CHECK_VALUE(flag, true);
+		CHECK_VALUE(small, -3);
+		auto size = reader.start_array(u8"values");
+		CHECK_OK(size);
+		CHECK_EQ(size.value(), 3);
+		CHECK_OK(reader.end_array());
+		CHECK_OK(reader.start_object(u8"child"));
+		CHECK_OK(reader.read(u8"copied", copied));
+		CHECK_VALUE(copied, 1);
+		CHECK_OK(reader.end_object());
+		CHECK_OK(reader.end_object());
+	}
+}
+
+TEST_CASE_FIXTURE(JSONTests, "in situ") {
+	using namespace auxiliary;
+
+	const u8string_view json = u8R"({"name":"in\tsitu","value":7})";
+
+	std::vector<char8_t> buffer(json.size() + JsonReader::insitu_padding);
+	std::memcpy(buffer.data(), json.data(), json.size());
+
+	JsonReader reader(std::span{buffer}, json.size());
+	const char8_t* name;
+	int64_t value;
+	CHECK_OK(reader.start_object(u8""));
+	CHECK_OK(reader.read(u8"name", name));
+	CHECK_OK(reader.read(u8"value", value));
+	CHECK_OK(reader.end_object());
+	CHECK_VALUE(u8string_view{name}, u8string_view{u8"in\tsitu"});
+	CHECK_VALUE(value, 7);
+	CHECK(name >= buffer.data());
+	CHECK(name < buffer.data() + buffer.size());
+
+	// without the padding the input is copied
+	std::vector<char8_t> tight(json.begin(), json.end());
+	reader.reset(std::span{tight}, tight.size());
+	CHECK_OK(reader.start_object(u8""));
+	CHECK_OK(reader.read(u8"name", name));
+	CHECK_OK(reader.end_object());
+	CHECK_VALUE(u8string_view{name}, u8string_view{u8"in\tsitu"});
+	CHECK((name < tight.data() || name >= tight.data() + tight.size()));
+}
+
+TEST_CASE_FIXTURE(JSONTests, "from file") {
+	using namespace auxiliary;
+
+	JsonWriter writer(2);
+	CHECK_OK(writer.start_object(u8""));
+	CHECK_OK(writer.write(u8"name", u8string_view{u8"mapped\n"}));
+	CHECK_OK(writer.write(u8"value", static_cast<int64_t>(42)));
+	CHECK_OK(writer.end_object());
+	CHECK_OK(writer.dump_to_file(u8"json_from_file.json"));
+
+	auto reader = JsonReader::from_file(u8"json_from_file.json");
+	CHECK_OK(reader);
+	u8string name;
+	int64_t value;
+	CHECK_OK(reader->start_object(u8""));
+	CHECK_OK(reader->read(u8"name", name));
+	CHECK_OK(reader->read(u8"value", value));
+	CHECK_OK(reader->end_object());
+	CHECK_VALUE(name, u8string_view{u8"mapped\n"});
+	CHECK_VALUE(value, 42);
+
+	JsonReader moved = std::move(reader.value());
+	CHECK_OK(moved.start_object(u8""));
+	CHECK_OK(moved.read(u8"value", value));
+	CHECK_OK(moved.end_object());
+
+	auto missing = JsonReader::from_file(u8"json_missing_file.json");
+	CHECK_ERROR(missing, JsonErrorCode::FileIOFailed);
+}
+
+TEST_CASE_FIXTURE(JSONTests, "key index") {
+	using namespace auxiliary;
+
+	std::vector<std::u8string> keys;
+	for (int i = 0; i < 200; i++) {
+		const auto text = std::to_string(i);
+		keys.push_back(u8"key" + std::u8string(text.begin(), text.end()));
+	}
+	auto key_of = [&](int64_t i) { return u8string_view{keys[i].data(), keys[i].size()}; };
+
+	JsonWriter writer(3);
+	CHECK_OK(writer.start_object(u8""));
+	for (int64_t i = 0; i < 200; i++) {
+		CHECK_OK(writer.write(key_of(i), i));
+	}
+	CHECK_OK(writer.start_object(u8"nested"));
+	CHECK_OK(writer.write(u8"inner", true));
+	CHECK_OK(writer.end_object());
+	CHECK_OK(writer.end_object());
+	const u8string json = writer.dump();
+
+	for (size_t threshold : {size_t{0}, size_t{32}, SIZE_MAX}) {
+		JsonReader reader(json);
+		reader.set_key_index_threshold(threshold);
+		CHECK_OK(reader.start_object(u8""));
+		for (int64_t i = 199; i >= 0; i--) {
+			int64_t value;
+			CHECK_OK(reader.read(key_of(i), value));
+			CHECK_VALUE(value, i);
+		}
+		CHECK_READ_ERROR<int64_t>(reader, u8"key200", JsonErrorCode::KeyNotFound);
+
+		int64_t value;
+		bool inner;
+		CHECK_OK(reader.read(JsonStaticKey{u8"key42"}, value));
+		CHECK_VALUE(value, 42);
+		CHECK_OK(reader.start_object(JsonStaticKey{u8"nested"}));
+		CHECK_OK(reader.read(JsonStaticKey{u8"inner"}, inner));
+		CHECK_VALUE(inner, true);
+		CHECK_OK(reader.end_object());
+		CHECK_OK(reader.end_object());
+	}
+}
+
+TEST_CASE_FIXTURE(JSONTests, "ordered reads") {
+	using namespace auxiliary;
+
+	JsonReader reader(u8R"({"a":1,"b":2,"c":{"d":3},"e":4})");
+	int64_t value;
+	CHECK_OK(reader.start_object(u8""));
+	CHECK_OK(reader.read(u8"a", value));
+	CHECK_VALUE(value, 1);
+	CHECK_OK(reader.read(u8"b", value));
+	CHECK_VALUE(value, 2);
+	CHECK_OK(reader.start_object(u8"c"));
+	CHECK_OK(reader.read(u8"d", value));
+	CHECK_VALUE(value, 3);
+	CHECK_OK(reader.end_object());
+	CHECK_OK(reader.read(u8"e", value));
+	CHECK_VALUE(value, 4);
+
+	// out of order and repeated reads fall back to a scan
+	CHECK_OK(reader.read(u8"a", value));
+	CHECK_VALUE(value, 1);
+	CHECK_OK(reader.read(u8"e", value));
+	CHECK_VALUE(value, 4);
+	CHECK_OK(reader.read(u8"e", value));
+	CHECK_VALUE(value, 4);
+	CHECK_READ_ERROR<int64_t>(reader, u8"f", JsonErrorCode::KeyNotFound);
+	CHECK_OK(reader.read(u8"b", value));
+	CHECK_VALUE(value, 2);
+	CHECK_OK(reader.end_object());
+}
+
+TEST_CASE_FIXTURE(JSONTests, "duplicate keys") {
+	using namespace auxiliary;
+
+	// the cursor sits on the second "a" after reading "b", the first one is still the one read
+	for (size_t threshold : {size_t{0}, size_t{32}}) {
+		JsonReader reader(u8R"({"a":1,"b":2,"a":3,"c":4})");
+		reader.set_key_index_threshold(threshold);
+		int64_t value;
+		CHECK_OK(reader.start_object(u8""));
+		CHECK_OK(reader.read(u8"a", value));
+		CHECK_VALUE(value, 1);
+		CHECK_OK(reader.read(u8"b", value));
+		CHECK_VALUE(value, 2);
+		CHECK_OK(reader.read(u8"a", value));
+		CHECK_VALUE(value, 1);
+		CHECK_OK(reader.read(u8"c", value));
+		CHECK_VALUE(value, 4);
+		CHECK_OK(reader.end_object());
+	}
+}
+
+TEST_CASE_FIXTURE(JSONTests, "on demand") {
+	using namespace auxiliary;
+
+	const u8string_view json = u8R"({"skipped":{"deep":[1,{"x":"}"}]},"name":"on\"demand","values":[1,[2,3],{"k":4}],"count":3,"ratio":0.5,"tag":"plain"})";
+
+	JsonReader reader(json, JsonReadMode::OnDemand);
+	u8string name;
+	int64_t count, element;
+	double ratio;
+	CHECK_OK(reader.start_object(u8""));
+	CHECK_OK(reader.read(u8"name", name));
+	CHECK_VALUE(name, u8string_view{u8"on\"demand"});
+
+	auto size = reader.start_array(u8"values");
+	CHECK_OK(size);
+	CHECK_EQ(size.value(), 3);
+	CHECK_OK(reader.read(u8"", element));
+	CHECK_VALUE(element, 1);
+	CHECK_OK(reader.start_array(u8""));
+	CHECK_OK(reader.end_array());
+	CHECK_OK(reader.start_object(u8""));
+	CHECK_OK(reader.read(u8"k", element));
+	CHECK_VALUE(element, 4);
+	CHECK_OK(reader.end_object());
+	CHECK_READ_ERROR<int64_t>(reader, u8"", JsonErrorCode::KeyNotFound);
+	CHECK_OK(reader.end_array());
+
+	CHECK_OK(reader.read(u8"ratio", ratio));
+	CHECK_VALUE(ratio, 0.5);
+	CHECK_OK(reader.read(u8"count", count));
+	CHECK_VALUE(count, 3);
+	CHECK_READ_ERROR<int64_t>(reader, u8"missing", JsonErrorCode::KeyNotFound);
+	CHECK_ERROR(reader.start_array(u8"skipped"), JsonErrorCode::ScopeTypeMismatch);
+
+	// strings without escapes are views into the input, others reuse the same memory however often they are read
+	u8string_view tag;
+	CHECK_OK(reader.read(u8"tag", tag));
+	CHECK_VALUE(tag, u8string_view{u8"plain"});
+	CHECK(tag.data() > json.data());
+	CHECK(tag.data() < json.data() + json.size());
+	const char8_t* first = nullptr;
+	for (int i = 0; i < 1000; i++) {
+		const char8_t* escaped = nullptr;
+		CHECK_OK(reader.read(u8"name", escaped));
+		first = first ? first : escaped;
+		CHECK_EQ(escaped, first);
+	}
+	CHECK_VALUE(first, u8string_view{u8"on\"demand"});
+	CHECK_OK(reader.end_object());
+
+	// malformed input is reported once it is visited
+	reader.reset(u8R"({"ok":1,"broken":[1,)");
+	CHECK_OK(reader.start_object(u8""));
+	CHECK_OK(reader.read(u8"ok", count));
+	CHECK_ERROR(reader.start_array(u8"broken"), JsonErrorCode::ParseFailed);
+
+	// scalars follow the JSON grammar, whatever from_chars takes beyond it is rejected as in Document mode
+	for (const char8_t* token : {u8"nan", u8"inf", u8"-infinity", u8"01", u8"+1", u8"1.", u8".5", u8"1e", u8"-", u8"0x10", u8"truex", u8"nul"}) {
+		std::u8string bad = u8"{\"x\":";
+		bad += token;
+		bad += u8"}";
+		const u8string_view view{bad.data(), bad.size()};
+		double x = 7;
+		JsonReader lazy_reader(view, JsonReadMode::OnDemand);
+		CHECK_OK(lazy_reader.start_object(u8""));
+		CHECK_ERROR(lazy_reader.read(u8"x", x), JsonErrorCode::ParseFailed);
+		CHECK_VALUE(x, 7.0);
+		CHECK(JsonReader(view).parse_error() != nullptr);
+	}
+}
+
+TEST_CASE_FIXTURE(JSONTests, "ndjson") {
+	using namespace auxiliary;
+
+	struct StringSource : JsonSource {
+		std::u8string text;
+		size_t position = 0;
+
+		bool read(char8_t* buffer, size_t capacity, size_t& size) override {
+			size = std::min(capacity, text.size() - position);
+			std::memcpy(buffer, text.data() + position, size);
+			position += size;
+			return true;
+		}
+	};
+
+	for (auto mode : {JsonReadMode::Document, JsonReadMode::OnDemand}) {
+		StringSource source;
+		source.text = u8"{\"id\":1}\n\n{\"id\":2,\"name\":\"longer than one chunk\"}\r\n{\"id\":3}";
+
+		NdjsonReader ndjson(source, mode, 8);
+		int64_t expected = 1;
+		const size_t lines[] = {1, 3, 4};
+		for (auto record = ndjson.next(); record.has_value() && record.value(); record = ndjson.next()) {
+			JsonReader& reader = *record.value();
+			int64_t id;
+			CHECK_OK(reader.start_object(u8""));
+			CHECK_OK(reader.read(u8"id", id));
+			CHECK_OK(reader.end_object());
+			CHECK_VALUE(id, expected);
+			CHECK_EQ(ndjson.line(), lines[expected - 1]);
+			expected++;
+		}
+		CHECK_EQ(expected, 4);
+	}
+
+	auto missing = NdjsonReader::from_file(u8"json_missing_file.jsonl");
+	CHECK_ERROR(missing, JsonErrorCode::FileIOFailed);
+}
+
+TEST_CASE_FIXTURE(JSONTests, "ndjson parallel") {
+	using namespace auxiliary;
+
+	std::u8string input;
+	for (int i = 0; i < 1000; i++) {
+		const auto line = std::to_string(i);
+		input += u8"{\"id\":" + std::u8string(line.begin(), line.end()) + u8"}\n";
+		if (i % 100 == 0) {
+			input += u8"\n";
+		}
+	}
+
+	NdjsonParallelOptions options;
+	options.threads = 4;
+	options.chunk_size = 256;
+
+	std::vector<int64_t> ids;
+	CHECK_OK(NdjsonReader::parse_parallel(u8string_view{input.data(), input.size()}, [&](JsonReader& reader, size_t) {
+		int64_t id = -1;
+		(void) reader.start_object(u8"");
+		(void) reader.read(u8"id", id);
+		ids.push_back(id);
+	}, options));
+	CHECK_EQ(ids.size(), 1000);
+	for (size_t i = 0; i < ids.size(); i++) {
+		CHECK_EQ(ids[i], static_cast<int64_t>(i));
+	}
+
+	options.ordered = false;
+	std::atomic<int64_t> sum = 0;
+	std::atomic<size_t> count = 0;
+	CHECK_OK(NdjsonReader::parse_parallel(u8string_view{input.data(), input.size()}, [&](JsonReader& reader, size_t) {
+		int64_t id = 0;
+		(void) reader.start_object(u8"");
+		(void) reader.read(u8"id", id);
+		sum += id;
+		count++;
+	}, options));
+	CHECK_EQ(count.load(), 1000);
+	CHECK_EQ(sum.load(), 999 * 1000 / 2);
+
+	// the line counts the blank lines before it as well
+	const size_t broken_offset = input.size();
+	input += u8"{broken\n{\"id\":0}\n{also broken\n";
+	for (bool ordered : {true, false}) {
+		options.ordered = ordered;
+		JsonParseError error;
+		options.error = &error;
+		auto broken = NdjsonReader::parse_parallel(u8string_view{input.data(), input.size()}, [&](JsonReader&, size_t) {}, options);
+		CHECK_ERROR(broken, JsonErrorCode::ParseFailed);
+		CHECK_EQ(error.offset, broken_offset + 1);
+		CHECK_EQ(error.line, 1011);
+	}
+	options.error = nullptr;
+
+	// the other workers are joined before the exception reaches the caller
+	for (bool ordered : {true, false}) {
+		options.ordered = ordered;
+		std::atomic<size_t> calls = 0;
+		CHECK_THROWS_AS((void) NdjsonReader::parse_parallel(u8string_view{input.data(), input.size()}, [&](JsonReader&, size_t offset) {
+			calls++;
+			if (offset > input.size() / 2) {
+				throw std::runtime_error("stop");
+			}
+		}, options), std::runtime_error);
+		CHECK_GT(calls.load(), 0);
+	}
+}
+
+TEST_CASE_FIXTURE(JSONTests, "document framer") {
+	using namespace auxiliary;
+
+	const u8string_view json = u8R"( {"text":"]}\"","values":[1,{"n":2}]}{"next":3})";
+
+	for (size_t step : {size_t{1}, size_t{7}, json.size()}) {
+		JsonDocumentFramer framer;
+		CHECK_FALSE(framer.complete());
+
+		size_t fed = 0;
+		bool complete = false;
+		while (!complete && fed < json.size()) {
+			const size_t size = std::min(step, json.size() - fed);
+			auto result = framer.feed(json.data() + fed, size);
+			CHECK_OK(result);
+			complete = result.value();
+			fed += size;
+		}
+		CHECK(complete);
+		CHECK(framer.complete());
+
+		// the rest of the input arrives after the first document is complete
+		CHECK_OK(framer.feed(json.data() + fed, json.size() - fed));
+
+		JsonReader& reader = framer.reader();
+		u8string text;
+		CHECK_OK(reader.start_object(u8""));
+		CHECK_OK(reader.read(u8"text", text));
+		CHECK_VALUE(text, u8string_view{u8"]}\""});
+		CHECK_OK(reader.end_object());
+
+		auto next = framer.reset();
+		CHECK_OK(next);
+		CHECK(next.value());
+		int64_t value;
+		CHECK_OK(framer.reader().start_object(u8""));
+		CHECK_OK(framer.reader().read(u8"next", value));
+		CHECK_VALUE(value, 3);
+
+		next = framer.reset();
+		CHECK_OK(next);
+		CHECK_FALSE(next.value());
+	}
+
+	// a framed document that does not parse is an error, also for the pieces after it, until reset()
+	JsonDocumentFramer framer;
+	CHECK_ERROR(framer.feed(u8"{\"a\":1,}"), JsonErrorCode::ParseFailed);
+	CHECK(framer.complete());
+	CHECK_ERROR(framer.feed(u8"{\"b\":2}"), JsonErrorCode::ParseFailed);
+	auto next = framer.reset();
+	CHECK_OK(next);
+	CHECK(next.value());
+}
+
+TEST_CASE_FIXTURE(JSONTests, "validate") {
+	using namespace auxiliary;
+
+	JsonStats stats = JsonReader::validate(u8R"({"a":[1,2,{"b":null}],"c":"x\u00e9\n","d":-1.5e+3})");
+	CHECK(stats.valid());
+	CHECK_VALUE(stats.max_depth, 3);
+	CHECK_VALUE(stats.value_count, 8);
+
+	stats = JsonReader::validate(u8"\"\u00e9\u20ac\U0001F600 long enough to take the vectorized path in the string scan\"");
+	CHECK(stats.valid());
+	CHECK_VALUE(stats.value_count, 1);
+
+	// offset of the first bad byte, the input size when it ends early
+	CHECK_VALUE(JsonReader::validate(u8"").error_offset, 0);
+	CHECK_VALUE(JsonReader::validate(u8"{\"a\":[1,2").error_offset, 9);
+	CHECK_VALUE(JsonReader::validate(u8"[1,]").error_offset, 3);
+	CHECK_VALUE(JsonReader::validate(u8"{\"a\":1,}").error_offset, 7);
+	CHECK_VALUE(JsonReader::validate(u8"[01]").error_offset, 2);
+	CHECK_VALUE(JsonReader::validate(u8"[true false]").error_offset, 6);
+	CHECK_VALUE(JsonReader::validate(u8"[1]]").error_offset, 3);
+	CHECK_VALUE(JsonReader::validate(u8"\"\\x\"").error_offset, 1);
+
+	// surrogates only come in escaped pairs, high then low
+	CHECK(JsonReader::validate(u8R"("\ud83d\ude00")").valid());
+	CHECK_VALUE(JsonReader::validate(u8R"("\ud83d")").error_offset, 1);
+	CHECK_VALUE(JsonReader::validate(u8R"("a\ud83dx")").error_offset, 2);
+	CHECK_VALUE(JsonReader::validate(u8R"("\ud83d\u0041")").error_offset, 1);
+	CHECK_VALUE(JsonReader::validate(u8R"("\ud83d\ud83d")").error_offset, 1);
+	CHECK_VALUE(JsonReader::validate(u8R"("\ude00\ud83d")").error_offset, 1);
+
+	const char8_t bad_utf8[] = {u8'"', 0xC0, 0xAF, u8'"', 0};
+	CHECK_VALUE(JsonReader::validate(bad_utf8).error_offset, 1);
+
+	stats = JsonReader::validate(u8"[[1,2],[3]]  x");
+	CHECK_FALSE(stats.valid());
+	CHECK_VALUE(stats.error_offset, 13);
+	CHECK_VALUE(stats.max_depth, 2);
+}
+
+TEST_CASE_FIXTURE(JSONTests, "stream escaping") {
+	using namespace auxiliary;
+
+	// long plain runs with escapes and multibyte characters on both sides of the vector width
+	const u8string_view text{u8"free text that runs past one vector block \"quoted\"\ttab\u00e9 and then \u20ac\U0001F600 keeps going for a while\x01"};
+	const u8string_view escaped{u8"free text that runs past one vector block \\\"quoted\\\"\\ttab\u00e9 and then \u20ac\U0001F600 keeps going for a while\\u0001"};
+	const char8_t invalid[] = {u8'a', 0xC3, 0x28, 0};
+
+	JsonWriter writer(2, JsonWriteMode::Stream);
+	CHECK_OK(writer.start_object(u8""));
+	CHECK_OK(writer.write(u8"text", text));
+	CHECK_ERROR(writer.write(u8"bad", u8string_view{invalid}), JsonErrorCode::InvalidUtf8);
+	CHECK_ERROR(writer.write(u8string_view{invalid}, true), JsonErrorCode::InvalidUtf8);
+	CHECK_OK(writer.end_object());
+
+	// rejected strings leave nothing behind
+	u8string expected = u8"{\"text\":\"";
+	expected += escaped;
+	expected += u8"\"}";
+	CHECK_VALUE(writer.dump(), expected);
+
+	// a long string is escaped slice by slice, with characters and escapes across every slice border
+	u8string long_text, long_expected = u8"{\"text\":\"";
+	for (int i = 0; i < 5000; i++) {
+		long_text += u8"\U0001F600a\"";
+		long_expected += u8"\U0001F600a\\\"";
+	}
+	long_expected += u8"\"}";
+	JsonWriter long_writer(1, JsonWriteMode::Stream);
+	CHECK_OK(long_writer.start_object(u8""));
+	CHECK_OK(long_writer.write(u8"text", long_text));
+	CHECK_OK(long_writer.end_object());
+	CHECK_VALUE(long_writer.dump(), long_expected);
+}
+
+TEST_CASE_FIXTURE(JSONTests, "bulk read") {
+	using namespace auxiliary;
+
+	const u8string_view json = u8R"({"small":[1,-2,127],"wide":[3,300,5],"reals":[0.5,2,-1e300],"flags":[true,false,1]})";
+
+	for (auto mode : {JsonReadMode::Document, JsonReadMode::OnDemand}) {
+		JsonReader reader(json, mode);
+		int8_t small[4] = {9, 9, 9, 9};
+		uint8_t wide[3] = {9, 9, 9};
+		uint16_t rest[2];
+		double reals[3];
+		float narrow[3] = {9, 9, 9};
+		bool flags[3] = {false, true, true};
+		size_t mismatch = 0;
+
+		// asking for more elements than remain stores nothing
+		CHECK_OK(reader.start_object(u8""));
+		CHECK_OK(reader.start_array(u8"small"));
+		CHECK_ERROR(reader.read(4, small), JsonErrorCode::KeyNotFound);
+		CHECK_VALUE(small[0], 9);
+		CHECK_OK(reader.read(3, small));
+		CHECK_VALUE(small[1], -2);
+		CHECK_VALUE(small[2], 127);
+		CHECK_VALUE(small[3], 9);
+		CHECK_OK(reader.end_array());
+
+		// 300 does not fit, nothing is stored and the read starts over at the same element
+		CHECK_OK(reader.start_array(u8"wide"));
+		CHECK_ERROR(reader.read(3, wide, &mismatch), JsonErrorCode::ElementTypeMismatch);
+		CHECK_VALUE(mismatch, 1);
+		CHECK_VALUE(wide[0], 9);
+		CHECK_OK(reader.read(1, wide));
+		CHECK_VALUE(wide[0], 3);
+		CHECK_VALUE(wide[1], 9);
+		CHECK_OK(reader.read(2, rest));
+		CHECK_VALUE(rest[0], 300);
+		CHECK_VALUE(rest[1], 5);
+		CHECK_ERROR(reader.read(1, wide), JsonErrorCode::KeyNotFound);
+		CHECK_OK(reader.end_array());
+
+		CHECK_OK(reader.start_array(u8"reals"));
+		CHECK_OK(reader.read(3, reals));
+		CHECK_VALUE(reals[1], 2.0);
+		CHECK_VALUE(reals[2], -1e300);
+		CHECK_OK(reader.end_array());
+		CHECK_OK(reader.start_array(u8"reals"));
+		CHECK_ERROR(reader.read(3, narrow, &mismatch), JsonErrorCode::ElementTypeMismatch);
+		CHECK_VALUE(mismatch, 2);
+		CHECK_VALUE(narrow[0], 9.0f);
+		CHECK_OK(reader.end_array());
+
+		CHECK_OK(reader.start_array(u8"flags"));
+		CHECK_ERROR(reader.read(3, flags, &mismatch), JsonErrorCode::ElementTypeMismatch);
+		CHECK_VALUE(mismatch, 2);
+		CHECK_VALUE(flags[0], false);
+		CHECK_VALUE(flags[1], true);
+		CHECK_OK(reader.read(2, flags));
+		CHECK_VALUE(flags[0], true);
+		CHECK_VALUE(flags[1], false);
+		CHECK_OK(reader.end_array());
+		CHECK_OK(reader.end_object());
+	}
+}
+
+TEST_CASE_FIXTURE(JSONTests, "bulk write") {
+	using namespace auxiliary;
+
+	int32_t ints[] = {-1, 2, 1 << 30};
+	// 0.1f is not exact, both modes must print the same widened digits as a single float write
+	std::vector<float> floats = {0.5f, -2.0f, 0.1f};
+	uint8_t bytes[] = {0, 255};
+	const char8_t* names[] = {u8"a", u8"b"};
+	const size_t lengths[] = {1, 1};
+	const long double wide[] = {1.5L, 2.0L};
+
+	for (auto mode : {JsonWriteMode::Document, JsonWriteMode::Stream}) {
+		JsonWriter writer(2, mode);
+		CHECK_OK(writer.start_object(u8""));
+		CHECK_OK(writer.write(3, u8"ints", ints));
+		CHECK_OK(writer.end_array());
+		CHECK_OK(writer.write(floats.size(), u8"floats", floats.data()));
+		CHECK_OK(writer.end_array());
+		CHECK_OK(writer.write(u8"float", 0.1f));
+		CHECK_OK(writer.write(2, u8"bytes", bytes));
+		// the array stays open, more elements can follow the bulk ones
+		CHECK_OK(writer.write(u8"", static_cast<uint64_t>(7)));
+		CHECK_OK(writer.end_array());
+		CHECK_OK(writer.write(2, u8"names", names, lengths));
+		CHECK_OK(writer.end_array());
+		// long double has no bulk writer and goes element by element, its array stays open as well
+		CHECK_OK(writer.write(2, u8"wide", wide));
+		CHECK_OK(writer.end_array());
+		CHECK_OK(writer.end_object());
+		CHECK_VALUE(writer.dump(), u8string_view{u8R"({"ints":[-1,2,1073741824],"floats":[0.5,-2.0,0.10000000149011612],"float":0.10000000149011612,"bytes":[0,255,7],"names":["a","b"],"wide":[1.5,2.0]})"});
+	}
+}
+
+struct TestVec3 {
+	float x, y, z;
+};
+
+struct TestTransform {
+	auxiliary::u8string name;
+	TestVec3 position;
+	int32_t layer;
+	bool visible;
+};
+
+AUXILIARY_JSON_FIELDS(TestVec3, AUXILIARY_JSON_FIELD(TestVec3, x), AUXILIARY_JSON_FIELD(TestVec3, y), AUXILIARY_JSON_FIELD(TestVec3, z));
+AUXILIARY_JSON_FIELDS(TestTransform, AUXILIARY_JSON_FIELD(TestTransform, name), AUXILIARY_JSON_FIELD(TestTransform, position),
+                      AUXILIARY_JSON_FIELD(TestTransform, layer), AUXILIARY_JSON_FIELD(TestTransform, visible));
+
+TEST_CASE_FIXTURE(JSONTests, "fields") {
+	using namespace auxiliary;
+
+	static_assert(std::get<1>(JsonFields<TestVec3>::fields).key.hash() == Hash<u8string_view>()(u8"y"));
+	const TestTransform transform{u8"camera", {1.0f, -2.5f, 0.25f}, -3, true};
+
+	for (auto mode : {JsonWriteMode::Document, JsonWriteMode::Stream}) {
+		JsonWriter writer(3, mode);
+		CHECK_OK(writer.start_object(u8""));
+		CHECK_OK(writer.write(u8"transform", transform));
+		CHECK_OK(writer.end_object());
+		const u8string json = writer.dump();
+		CHECK_VALUE(json, u8string_view{u8R"({"transform":{"name":"camera","position":{"x":1.0,"y":-2.5,"z":0.25},"layer":-3,"visible":true}})"});
+
+		for (auto read_mode : {JsonReadMode::Document, JsonReadMode::OnDemand}) {
+			JsonReader reader(u8string_view{json.data(), json.size()}, read_mode);
+			TestTransform result{};
+			CHECK_OK(reader.start_object(u8""));
+			CHECK_OK(reader.read(u8"transform", result));
+			CHECK_OK(reader.end_object());
+			CHECK_VALUE(result.name, transform.name);
+			CHECK_VALUE(result.position.y, transform.position.y);
+			CHECK_VALUE(result.layer, transform.layer);
+			CHECK_VALUE(result.visible, transform.visible);
+		}
+	}
+
+	for (auto read_mode : {JsonReadMode::Document, JsonReadMode::OnDemand}) {
+		// an escaped NUL stays inside the member
+		JsonReader reader(u8R"({"t":{"name":"a\u0000b","position":{"x":0,"y":0,"z":0},"layer":0,"visible":false}})", read_mode);
+		TestTransform result{};
+		CHECK_OK(reader.start_object(u8""));
+		CHECK_OK(reader.read(u8"t", result));
+		CHECK_VALUE(result.name.size(), 3);
+		CHECK_VALUE(result.name[1], u8'\0');
+	}
+
+	JsonReader reader(u8R"({"v":{"x":1,"y":2}})");
+	CHECK_OK(reader.start_object(u8""));
+	CHECK_READ_ERROR<TestVec3>(reader, u8"v", JsonErrorCode::KeyNotFound);
+}
+
+TEST_CASE_FIXTURE(JSONTests, "splice") {
+	using namespace auxiliary;
+
+	auto build = [](JsonWriter& writer, int64_t id) {
+		CHECK_OK(writer.start_object(u8""));
+		CHECK_OK(writer.write(u8"id", id));
+		CHECK_OK(writer.start_array(u8"tags"));
+		CHECK_OK(writer.write(u8"", u8string_view{u8"part"}));
+		CHECK_OK(writer.end_array());
+		CHECK_OK(writer.end_object());
+	};
+
+	for (auto mode : {JsonWriteMode::Document, JsonWriteMode::Stream}) {
+		// children are built in parallel and spliced in order
+		std::vector<std::unique_ptr<JsonWriter>> children;
+		std::vector<std::thread> workers;
+		for (int64_t i = 0; i < 4; i++) {
+			children.push_back(std::make_unique<JsonWriter>(2, mode));
+		}
+		for (int64_t i = 0; i < 4; i++) {
+			workers.emplace_back([&, i] { build(*children[i], i); });
+		}
+		for (auto& worker : workers) {
+			worker.join();
+		}
+
+		JsonWriter parent(2, mode);
+		CHECK_OK(parent.start_object(u8""));
+		CHECK_OK(parent.start_array(u8"parts"));
+		for (auto& child : children) {
+			CHECK_OK(parent.splice(u8"", *child));
+		}
+		CHECK_OK(parent.end_array());
+		// spliced children are empty until they build another root
+		CHECK_ERROR(parent.splice(u8"last", *children[0]), JsonErrorCode::ChildNotSpliceable);
+
+		// a child is reset by splicing and can build the next subtree
+		build(*children[0], 4);
+		CHECK_OK(parent.splice(u8"last", *children[0]));
+		CHECK_OK(parent.end_object());
+		children.clear();
+
+		CHECK_VALUE(parent.dump(), u8string_view{u8R"({"parts":[{"id":0,"tags":["part"]},{"id":1,"tags":["part"]},{"id":2,"tags":["part"]},{"id":3,"tags":["part"]}],"last":{"id":4,"tags":["part"]}})"});
+	}
+
+	JsonWriter parent(2);
+	JsonWriter stream_child(2, JsonWriteMode::Stream);
+	JsonWriter open_child(2);
+	build(stream_child, 0);
+	CHECK_OK(open_child.start_object(u8""));
+	CHECK_OK(parent.start_object(u8""));
+	CHECK_ERROR(parent.splice(u8"stream", stream_child), JsonErrorCode::ChildNotSpliceable);
+	CHECK_ERROR(parent.splice(u8"open", open_child), JsonErrorCode::ChildNotSpliceable);
+}
+
+TEST_CASE_FIXTURE(JSONTests, "path") {
+	using namespace auxiliary;
+
+	const u8string_view json = u8R"({"a":{"b":[10,{"c":"x\"y"},-3.5],"d":true},"m/n":{"~k":null},"e":[]})";
+
+	CHECK_ERROR(JsonPath::compile(u8"/a~2"), JsonErrorCode::InvalidPath);
+	CHECK_ERROR(JsonPath::compile(u8"a..b"), JsonErrorCode::InvalidPath);
+	const auto pointer = JsonPath::compile(u8"/m~1n/~0k");
+	const auto dotted = JsonPath::compile(u8"a.b.1.c");
+	const auto leading_zero = JsonPath::compile(u8"a.b.01");
+	CHECK_OK(pointer);
+	CHECK_OK(dotted);
+	CHECK_VALUE(dotted->size(), 4);
+
+	const JsonPath paths[] = {
+		*JsonPath::compile(u8"a.b.2"),
+		*JsonPath::compile(u8"a.d"),
+		*JsonPath::compile(u8"a.b.0"),
+		*JsonPath::compile(u8"a.x.y"),
+		*JsonPath::compile(u8"e"),
+		*dotted,
+	};
+
+	for (auto mode : {JsonReadMode::Document, JsonReadMode::OnDemand}) {
+		JsonReader reader(json, mode);
+
+		auto value = reader.resolve(*dotted);
+		CHECK_OK(value);
+		CHECK_VALUE(value->type, JsonPathValue::kString);
+		CHECK_VALUE(u8string_view{value->string, value->length}, u8string_view{u8"x\"y"});
+		value = reader.resolve(*pointer);
+		CHECK_OK(value);
+		CHECK_VALUE(value->type, JsonPathValue::kNull);
+		CHECK_ERROR(reader.resolve(*leading_zero), JsonErrorCode::KeyNotFound);
+
+		JsonPathValue values[std::size(paths)];
+		CHECK_ERROR(reader.resolve(paths, std::span{values, 2}), JsonErrorCode::BufferTooSmall);
+		CHECK_OK(reader.resolve(paths, values));
+		CHECK_VALUE(values[0].real, -3.5);
+		CHECK_VALUE(values[1].boolean, true);
+		CHECK_VALUE(values[2].uint, 10);
+		CHECK_VALUE(values[3].type, JsonPathValue::kMissing);
+		CHECK_VALUE(values[4].type, JsonPathValue::kArray);
+		CHECK_VALUE(values[5].type, JsonPathValue::kString);
+
+		// paths start from the open scope
+		CHECK_OK(reader.start_object(u8""));
+		CHECK_OK(reader.start_object(u8"a"));
+		value = reader.resolve(*JsonPath::compile(u8"/b/1/c"));
+		CHECK_OK(value);
+		CHECK_VALUE(value->length, 3);
+		CHECK_OK(reader.end_object());
+		CHECK_OK(reader.end_object());
+	}
+
+	// repeated lookups against the same document keep the memory of an on demand reader flat
+	JsonReader reader(u8string_view{u8R"({"a":{"c":"x\"y","p":"plain"}})"}, JsonReadMode::OnDemand);
+	const auto escaped = JsonPath::compile(u8"a.c");
+	const auto plain = JsonPath::compile(u8"a.p");
+	const char8_t* first = nullptr;
+	for (int i = 0; i < 10000; i++) {
+		auto value = reader.resolve(*escaped);
+		CHECK_OK(value);
+		first = first ? first : value->string;
+		CHECK_EQ(value->string, first);
+	}
+	auto value = reader.resolve(*plain);
+	CHECK_OK(value);
+	CHECK_VALUE(u8string_view{value->string, value->length}, u8string_view{u8"plain"});
+	CHECK(value->string != first);
+}
+
+TEST_CASE_FIXTURE(JSONTests, "parse error") {
+	using namespace auxiliary;
+
+	// the error sits behind a long string, only the bytes around it end up in the excerpt
+	std::u8string json = u8"{\"a\":1,\n\"b\":\"";
+	json.append(1000, u8'x');
+	json += u8"\"\n,}";
+
+	JsonReader reader(json.data(), json.size());
+	const JsonParseError* error = reader.parse_error();
+	REQUIRE(error != nullptr);
+	CHECK_GT(error->offset, 1000);
+	CHECK_LT(error->offset, json.size());
+	CHECK_GE(error->line, 2);
+	CHECK(error->message != nullptr);
+	CHECK_LE(error->excerpt_length, JsonParseError::excerpt_capacity);
+	CHECK_EQ(error->context().data()[error->excerpt_offset], json[error->offset]);
+
+	reader.reset(u8string_view{u8R"({"a":1})"});
+	CHECK_EQ(reader.parse_error(), nullptr);
+	int64_t a = 0;
+	CHECK_OK(reader.start_object(u8""));
+	CHECK_OK(reader.read(u8"a", a));
+	CHECK_OK(reader.end_object());
+}
+
+TEST_CASE_FIXTURE(JSONTests, "raw numbers") {
+	using namespace auxiliary;
+
+	const u8string_view json = u8R"({"pi":3.14159265358979323846,"big":300,"neg":-1,"huge":1e300,"name":"pi"})";
+
+	for (auto mode : {JsonReadMode::RawNumbers, JsonReadMode::OnDemand}) {
+		JsonReader reader(json, mode);
+		JsonRawNumber pi;
+		CHECK_OK(reader.start_object(u8""));
+		CHECK_OK(reader.read(u8"pi", pi));
+		CHECK_VALUE(pi.view(), u8string_view{u8"3.14159265358979323846"});
+		CHECK_ERROR(reader.read(u8"name", pi), JsonErrorCode::ElementTypeMismatch);
+
+		// the text is converted when a number is asked for
+		double real = 0;
+		CHECK_OK(reader.read(u8"huge", real));
+		CHECK_VALUE(real, 1e300);
+
+		// values that don't fit are reported and the target keeps what it had
+		uint8_t small = 7;
+		uint64_t unsigned_value = 7;
+		float narrow = 7;
+		int16_t fits = 0;
+		CHECK_ERROR(reader.read(u8"big", small), JsonErrorCode::NumberOutOfRange);
+		CHECK_VALUE(small, 7);
+		CHECK_ERROR(reader.read(u8"neg", unsigned_value), JsonErrorCode::NumberOutOfRange);
+		CHECK_VALUE(unsigned_value, 7);
+		CHECK_ERROR(reader.read(u8"huge", narrow), JsonErrorCode::NumberOutOfRange);
+		CHECK_OK(reader.read(u8"big", fits));
+		CHECK_VALUE(fits, 300);
+		CHECK_OK(reader.end_object());
+
+		for (auto write_mode : {JsonWriteMode::Document, JsonWriteMode::Stream}) {
+			JsonWriter writer(1, write_mode);
+			CHECK_OK(writer.start_object(u8""));
+			CHECK_OK(writer.write(u8"pi", pi));
+			CHECK_OK(writer.end_object());
+			CHECK_VALUE(writer.dump(), u8string_view{u8R"({"pi":3.14159265358979323846})"});
+		}
+	}
+
+	for (auto write_mode : {JsonWriteMode::Document, JsonWriteMode::Stream}) {
+		// raw text that isn't exactly one number would break the output, the writer is left as it was
+		const u8string_view injected = u8R"(1,"x":2)";
+		JsonWriter writer(1, write_mode);
+		CHECK_OK(writer.start_object(u8""));
+		CHECK_ERROR(writer.write(u8"n", JsonRawNumber{injected.data(), injected.size()}), JsonErrorCode::UnknownError);
+		CHECK_ERROR(writer.write(u8"n", JsonRawNumber{}), JsonErrorCode::UnknownError);
+		CHECK_ERROR(writer.write(u8"n", JsonRawNumber{u8"1.", 2}), JsonErrorCode::UnknownError);
+		CHECK_OK(writer.write(u8"n", JsonRawNumber{u8"-0.5e3", 6}));
+		CHECK_OK(writer.end_object());
+		CHECK_VALUE(writer.dump(), u8string_view{u8R"({"n":-0.5e3})"});
+	}
+
+	JsonWriter patched(1);
+	CHECK_OK(patched.start_object(u8""));
+	CHECK_OK(patched.end_object());
+	CHECK_ERROR(patched.set(*JsonPath::compile(u8"n"), JsonRawNumber{u8"01", 2}), JsonErrorCode::UnknownError);
+	CHECK_OK(patched.set(*JsonPath::compile(u8"n"), JsonRawNumber{u8"10", 2}));
+	CHECK_VALUE(patched.dump(), u8string_view{u8R"({"n":10})"});
+
+	JsonReader reader(json);
+	JsonRawNumber pi;
+	CHECK_OK(reader.start_object(u8""));
+	CHECK_ERROR(reader.read(u8"pi", pi), JsonErrorCode::UnknownTypeToRead);
+	CHECK_OK(reader.end_object());
+}
+
+TEST_CASE_FIXTURE(JSONTests, "integer as real") {
+	using namespace auxiliary;
+
+	// integers read into floating point targets the same way in every mode, members of JsonFields types included
+	for (auto mode : {JsonReadMode::Document, JsonReadMode::OnDemand, JsonReadMode::RawNumbers}) {
+		JsonReader reader(u8R"({"x":5,"n":-2,"v":{"x":1,"y":-2,"z":3}})", mode);
+		double x = 0;
+		float n = 0;
+		TestVec3 v{};
+		CHECK_OK(reader.start_object(u8""));
+		CHECK_OK(reader.read(u8"x", x));
+		CHECK_VALUE(x, 5.0);
+		CHECK_OK(reader.read(u8"n", n));
+		CHECK_VALUE(n, -2.0f);
+		CHECK_OK(reader.read(u8"v", v));
+		CHECK_VALUE(v.x, 1.0f);
+		CHECK_VALUE(v.y, -2.0f);
+		CHECK_VALUE(v.z, 3.0f);
+		CHECK_OK(reader.end_object());
+	}
+}
+
+TEST_CASE_FIXTURE(JSONTests, "edit") {
+	using namespace auxiliary;
+
+	const u8string_view json = u8R"({"id":7,"meta":{"tags":["a","b"],"note":"keep \"this\""},"score":1.5})";
+
+	for (auto mode : {JsonReadMode::Document, JsonReadMode::OnDemand}) {
+		JsonReader reader(json, mode);
+		JsonWriter writer(2);
+		CHECK_OK(writer.edit(reader));
+
+		CHECK_OK(writer.set(*JsonPath::compile(u8"id"), 8));
+		CHECK_OK(writer.set(*JsonPath::compile(u8"/meta/owner"), u8string_view{u8"ops"}));
+		CHECK_OK(writer.insert(*JsonPath::compile(u8"meta.tags.1"), u8string_view{u8"x"}));
+		CHECK_OK(writer.insert(*JsonPath::compile(u8"meta.tags.3"), nullptr));
+		CHECK_OK(writer.remove(*JsonPath::compile(u8"meta.tags.0")));
+
+		CHECK_ERROR(writer.remove(*JsonPath::compile(u8"missing")), JsonErrorCode::KeyNotFound);
+		CHECK_ERROR(writer.set(*JsonPath::compile(u8"meta.tags.9"), true), JsonErrorCode::KeyNotFound);
+		CHECK_ERROR(writer.set(*JsonPath::compile(u8"id.x"), true), JsonErrorCode::ScopeTypeMismatch);
+
+		// untouched members come out as they went in
+		CHECK_VALUE(writer.dump(), u8string_view{u8R"({"id":8,"meta":{"tags":["x","b",null],"note":"keep \"this\"","owner":"ops"},"score":1.5})"});
+
+		// a second edit starts over from the reader, members are replaced where they stand
+		CHECK_OK(writer.edit(reader));
+		CHECK_OK(writer.set(*JsonPath::compile(u8"meta.note"), 1));
+		CHECK_VALUE(writer.dump(), u8string_view{u8R"({"id":7,"meta":{"tags":["a","b"],"note":1},"score":1.5})"});
+	}
+
+	// malformed on demand input is found by the first edit and reported by every one after it
+	JsonReader broken(u8string_view{u8R"({"a":[1,}})"}, JsonReadMode::OnDemand);
+	JsonWriter edited(2);
+	CHECK_ERROR(edited.edit(broken), JsonErrorCode::ParseFailed);
+	CHECK_ERROR(edited.edit(broken), JsonErrorCode::ParseFailed);
+
+	JsonReader reader(json);
+	JsonWriter stream(2, JsonWriteMode::Stream);
+	CHECK_ERROR(stream.edit(reader), JsonErrorCode::ScopeTypeMismatch);
+}
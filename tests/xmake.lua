@@ -17,3 +17,4 @@ TEST("json")
 TEST("type_traits")
 TEST("intrusive_ptr")
 TEST("compressed_pair")
+TEST("inline_stack")
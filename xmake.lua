@@ -23,4 +23,5 @@ end
 
 includes("xmake/compile_flags.lua")
 includes("modules/xmake.lua")
-includes("tests/xmake.lua")
\ No newline at end of file
+includes("tests/xmake.lua")
+includes("benchmarks/xmake.lua")
\ No newline at end of file